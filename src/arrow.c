@@ -0,0 +1,1111 @@
+/*** arrow.c -- Arrow C data interface and IPC file writer
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include "arrow.h"
+
+#if !defined LIKELY
+# define LIKELY(_x)	__builtin_expect((_x), 1)
+#endif
+#if !defined UNLIKELY
+# define UNLIKELY(_x)	__builtin_expect((_x), 0)
+#endif
+#define countof(_x)	(sizeof(_x) / sizeof(*_x))
+
+/* rows a batch starts out with room for */
+#define ROWS_INI	(1024U)
+/* initial number of dictionary slots, a power of 2 */
+#define DICT_INI	(256U)
+
+#define DICTP(_m, _i)	((_m) >> (_i) & 1U)
+
+/* metadata version 5 and message header types of the IPC format */
+#define IPC_V5		(4U)
+enum {
+	HDR_SCHEMA = 1,
+	HDR_DICT = 2,
+	HDR_BATCH = 3,
+};
+/* type id of utf8 in Field's type union */
+#define TYPE_UTF8	(5U)
+
+static const char ipc_magic[8U] = "ARROW1\0";
+
+struct dict_s {
+	/* values back to back and their offsets, N + 1 of them */
+	char *dat;
+	size_t ndat;
+	size_t zdat;
+	int32_t *off;
+	size_t n;
+	size_t zoff;
+	/* open addressing, slots hold value ids plus 1 */
+	uint32_t *slot;
+	size_t nslot;
+};
+
+struct col_s {
+	/* validity bits */
+	uint8_t *vld;
+	/* value offsets, N + 1 of them, or dictionary indices */
+	int32_t *off;
+	/* value data, unused for dictionary-encoded columns */
+	char *dat;
+	size_t ndat;
+	size_t zdat;
+	size_t nnull;
+	struct dict_s *dict;
+};
+
+struct arrow_s {
+	const char *const *names;
+	uint64_t dictp;
+	/* rows in the current batch and room */
+	size_t n;
+	size_t zrow;
+	size_t ncol;
+	struct col_s col[];
+};
+
+/* exported arrays own their buffers */
+struct xarr_s {
+	struct ArrowArray a;
+	const void *buf[3U];
+	void *mem[3U];
+};
+
+/* exported struct arrays own their children */
+struct xtop_s {
+	const void *buf[1U];
+	struct ArrowArray *chld[];
+};
+
+/* exported schemas own their children */
+struct xsch_s {
+	struct ArrowSchema s;
+	struct ArrowSchema *chld[];
+};
+
+
+static int
+grow(void *ptr, size_t *z, size_t need, size_t elz)
+{
+/* make *PTR, an array of *Z elements of size ELZ, hold at least NEED
+ * elements, new elements are zeroed */
+	void **p = ptr;
+	size_t nz = *z ? *z : 64U;
+	void *np;
+
+	if (LIKELY(need <= *z)) {
+		return 0;
+	}
+	for (; nz < need; nz *= 2U);
+	if (UNLIKELY((np = realloc(*p, nz * elz)) == NULL)) {
+		return -1;
+	}
+	memset((char*)np + *z * elz, 0, (nz - *z) * elz);
+	*p = np;
+	*z = nz;
+	return 0;
+}
+
+static uint32_t
+str_hash(const char *s, size_t z)
+{
+	uint32_t h = 0x811c9dc5U;
+
+	for (size_t i = 0U; i < z; i++) {
+		h ^= (unsigned char)s[i];
+		h *= 0x01000193U;
+	}
+	return h;
+}
+
+
+/* dictionaries */
+static struct dict_s*
+make_dict(void)
+{
+	struct dict_s *d = calloc(1U, sizeof(*d));
+
+	if (UNLIKELY(d == NULL)) {
+		return NULL;
+	}
+	if (UNLIKELY(grow(&d->off, &d->zoff, 1U, sizeof(*d->off)) < 0)) {
+		free(d);
+		return NULL;
+	}
+	return d;
+}
+
+static void
+free_dict(struct dict_s *d)
+{
+	if (d == NULL) {
+		return;
+	}
+	free(d->dat);
+	free(d->off);
+	free(d->slot);
+	free(d);
+	return;
+}
+
+static int
+dict_rehash(struct dict_s *d)
+{
+	const size_t nz = d->nslot ? 2U * d->nslot : DICT_INI;
+	uint32_t *ns = calloc(nz, sizeof(*ns));
+
+	if (UNLIKELY(ns == NULL)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < d->n; i++) {
+		const char *s = d->dat + d->off[i];
+		const size_t z = (size_t)(d->off[i + 1U] - d->off[i]);
+		size_t k = str_hash(s, z) & (nz - 1U);
+
+		for (; ns[k]; k = (k + 1U) & (nz - 1U));
+		ns[k] = (uint32_t)(i + 1U);
+	}
+	free(d->slot);
+	d->slot = ns;
+	d->nslot = nz;
+	return 0;
+}
+
+static int32_t
+dict_id(struct dict_s *d, const char *s, size_t z)
+{
+/* return the id of S in D, adding it if need be, or -1 */
+	size_t k;
+
+	if (UNLIKELY(2U * (d->n + 1U) > d->nslot && dict_rehash(d) < 0)) {
+		return -1;
+	}
+	for (k = str_hash(s, z) & (d->nslot - 1U); d->slot[k];
+	     k = (k + 1U) & (d->nslot - 1U)) {
+		const size_t i = d->slot[k] - 1U;
+
+		if ((size_t)(d->off[i + 1U] - d->off[i]) == z &&
+		    !memcmp(d->dat + d->off[i], s, z)) {
+			return (int32_t)i;
+		}
+	}
+	/* new value */
+	if (UNLIKELY(d->ndat + z > INT32_MAX ||
+		     grow(&d->dat, &d->zdat, d->ndat + z, 1U) < 0 ||
+		     grow(&d->off, &d->zoff, d->n + 2U, sizeof(*d->off)) < 0)) {
+		return -1;
+	}
+	memcpy(d->dat + d->ndat, s, z);
+	d->ndat += z;
+	d->off[++d->n] = (int32_t)d->ndat;
+	d->slot[k] = (uint32_t)d->n;
+	return (int32_t)(d->n - 1U);
+}
+
+
+/* exports */
+static void
+xarr_release(struct ArrowArray *a)
+{
+	struct xarr_s *x = a->private_data;
+
+	if (a->dictionary != NULL && a->dictionary->release != NULL) {
+		a->dictionary->release(a->dictionary);
+	}
+	for (size_t i = 0U; i < countof(x->mem); i++) {
+		free(x->mem[i]);
+	}
+	a->release = NULL;
+	free(x);
+	return;
+}
+
+static struct ArrowArray*
+make_xarr(size_t len, size_t nnull, size_t nbuf)
+{
+	struct xarr_s *x = calloc(1U, sizeof(*x));
+
+	if (UNLIKELY(x == NULL)) {
+		return NULL;
+	}
+	x->a = (struct ArrowArray){
+		.length = (int64_t)len,
+		.null_count = (int64_t)nnull,
+		.n_buffers = (int64_t)nbuf,
+		.buffers = x->buf,
+		.release = xarr_release,
+		.private_data = x,
+	};
+	return &x->a;
+}
+
+static struct ArrowArray*
+dict_export(const struct dict_s *d)
+{
+/* snapshot of D's values as utf8 array */
+	struct ArrowArray *a = make_xarr(d->n, 0U, 3U);
+	struct xarr_s *x;
+
+	if (UNLIKELY(a == NULL)) {
+		return NULL;
+	}
+	x = a->private_data;
+	x->mem[1U] = malloc((d->n + 1U) * sizeof(*d->off));
+	x->mem[2U] = malloc(d->ndat + 1U);
+	if (UNLIKELY(x->mem[1U] == NULL || x->mem[2U] == NULL)) {
+		a->release(a);
+		return NULL;
+	}
+	memcpy(x->mem[1U], d->off, (d->n + 1U) * sizeof(*d->off));
+	memcpy(x->mem[2U], d->dat, d->ndat);
+	x->buf[1U] = x->mem[1U];
+	x->buf[2U] = x->mem[2U];
+	return a;
+}
+
+static void
+top_release(struct ArrowArray *a)
+{
+	struct xtop_s *x = a->private_data;
+
+	for (int64_t i = 0; i < a->n_children; i++) {
+		if (x->chld[i] != NULL && x->chld[i]->release != NULL) {
+			x->chld[i]->release(x->chld[i]);
+		}
+	}
+	free(x);
+	a->release = NULL;
+	return;
+}
+
+static void
+xsch_release(struct ArrowSchema *s)
+{
+	struct xsch_s *x = s->private_data;
+
+	for (int64_t i = 0; i < s->n_children; i++) {
+		if (x->chld[i] != NULL && x->chld[i]->release != NULL) {
+			x->chld[i]->release(x->chld[i]);
+		}
+	}
+	if (s->dictionary != NULL && s->dictionary->release != NULL) {
+		s->dictionary->release(s->dictionary);
+	}
+	s->release = NULL;
+	if (s != &x->s) {
+		/* the consumer's, only our part is ours */
+		s->private_data = NULL;
+	}
+	free(x);
+	return;
+}
+
+static struct xsch_s*
+make_xsch(const char *fmt, const char *name, int64_t flags, size_t nchld)
+{
+	struct xsch_s *x = calloc(1U, sizeof(*x) + nchld * sizeof(*x->chld));
+
+	if (UNLIKELY(x == NULL)) {
+		return NULL;
+	}
+	x->s = (struct ArrowSchema){
+		.format = fmt,
+		.name = name,
+		.flags = flags,
+		.n_children = (int64_t)nchld,
+		.children = x->chld,
+		.release = xsch_release,
+		.private_data = x,
+	};
+	return x;
+}
+
+
+/* the IPC file writer */
+struct fb_s {
+	unsigned char *b;
+	size_t n;
+	size_t z;
+	int rc;
+};
+
+/* kinds of table fields */
+enum {
+	FB_NONE = 0,
+	FB_U8 = 1,
+	FB_U16 = 2,
+	FB_U32 = 4,
+	FB_U64 = 8,
+	/* offset to an object written later */
+	FB_REF = 16,
+};
+
+struct fbf_s {
+	unsigned int k;
+	uint64_t v;
+};
+
+#define FB_MAXF		(8U)
+
+struct blk_s {
+	int64_t off;
+	int32_t mlen;
+	int64_t blen;
+};
+
+struct inod_s {
+	size_t len;
+	size_t nnull;
+};
+
+struct ibuf_s {
+	const void *p;
+	size_t z;
+};
+
+struct idict_s {
+	int32_t *off;
+	char *dat;
+	size_t n;
+};
+
+struct arrow_ipc_s {
+	int fd;
+	int rc;
+	/* bytes written so far */
+	int64_t pos;
+	/* record batches and dictionaries written */
+	struct blk_s *bat;
+	size_t nbat;
+	size_t zbat;
+	struct blk_s *dblk;
+	size_t ndblk;
+	size_t zdblk;
+	struct fb_s fb;
+	uint64_t dictp;
+	size_t ncol;
+	/* per column, the name and the largest dictionary seen */
+	char **names;
+	struct idict_s *dict;
+};
+
+static void
+le_put(unsigned char *b, uint64_t v, size_t z)
+{
+	for (size_t i = 0U; i < z; i++, v >>= 8U) {
+		b[i] = (unsigned char)v;
+	}
+	return;
+}
+
+static size_t
+fb_put(struct fb_s *fb, const void *p, size_t z, size_t align)
+{
+/* append Z bytes of P, or zeroes if P is NULL, aligned to ALIGN,
+ * return their position */
+	const size_t at = (fb->n + align - 1U) & ~(align - 1U);
+
+	if (UNLIKELY(grow(&fb->b, &fb->z, at + z, 1U) < 0)) {
+		fb->rc = -1;
+		return 0U;
+	}
+	memset(fb->b + fb->n, 0, at - fb->n);
+	if (p != NULL) {
+		memcpy(fb->b + at, p, z);
+	} else {
+		memset(fb->b + at, 0, z);
+	}
+	fb->n = at + z;
+	return at;
+}
+
+static void
+fb_ref(struct fb_s *fb, size_t at, size_t to)
+{
+/* point the offset at AT to TO */
+	if (LIKELY(!fb->rc)) {
+		le_put(fb->b + at, to - at, 4U);
+	}
+	return;
+}
+
+static size_t
+fb_table(struct fb_s *fb, const struct fbf_s *f, size_t nf, size_t *at)
+{
+/* write a table of NF fields F, the positions of FB_REF fields
+ * are put into AT for fb_ref() */
+	static const unsigned int ord[] = {FB_REF, FB_U32, FB_U64, FB_U16, FB_U8};
+	unsigned char vt[4U + 2U * FB_MAXF];
+	unsigned char tb[4U + 8U * FB_MAXF] = {0U};
+	size_t voff[FB_MAXF] = {0U};
+	size_t o = 4U, v, t;
+
+	/* widest fields first, the table itself is 8-aligned */
+	for (size_t j = 0U; j < countof(ord); j++) {
+		const size_t z = ord[j] == FB_REF ? 4U : ord[j];
+
+		for (size_t i = 0U; i < nf; i++) {
+			if (f[i].k != ord[j]) {
+				continue;
+			}
+			o = (o + z - 1U) & ~(z - 1U);
+			voff[i] = o;
+			if (f[i].k != FB_REF) {
+				le_put(tb + o, f[i].v, z);
+			}
+			o += z;
+		}
+	}
+	le_put(vt, 4U + 2U * nf, 2U);
+	le_put(vt + 2U, o, 2U);
+	for (size_t i = 0U; i < nf; i++) {
+		le_put(vt + 4U + 2U * i, voff[i], 2U);
+	}
+	v = fb_put(fb, vt, 4U + 2U * nf, 2U);
+	t = fb_put(fb, NULL, 0U, 8U);
+	le_put(tb, t - v, 4U);
+	t = fb_put(fb, tb, o, 8U);
+	for (size_t i = 0U; at != NULL && i < nf; i++) {
+		at[i] = t + voff[i];
+	}
+	return t;
+}
+
+static size_t
+fb_vec(struct fb_s *fb, size_t n, size_t align)
+{
+/* start a vector of N elements aligned to ALIGN, return the position
+ * of its length, elements are to be appended right away */
+	unsigned char len[4U];
+
+	if (align < 4U) {
+		align = 4U;
+	}
+	/* the elements follow the length */
+	while ((fb->n + 4U) % align) {
+		fb_put(fb, NULL, 1U, 1U);
+	}
+	le_put(len, n, 4U);
+	return fb_put(fb, len, 4U, 4U);
+}
+
+static size_t
+fb_str(struct fb_s *fb, const char *s)
+{
+	const size_t z = strlen(s);
+	const size_t at = fb_vec(fb, z, 4U);
+
+	fb_put(fb, s, z + 1U, 1U);
+	return at;
+}
+
+static void
+ipc_put(struct arrow_ipc_s *w, const void *p, size_t z)
+{
+/* write Z bytes of P, or zeroes if P is NULL */
+	static const char nil[64U];
+
+	for (const char *bp = p; z > 0U && !w->rc;) {
+		const size_t n = bp != NULL || z < sizeof(nil) ? z : sizeof(nil);
+		ssize_t nwr = write(w->fd, bp != NULL ? bp : nil, n);
+
+		if (UNLIKELY(nwr < 0)) {
+			if (errno == EINTR) {
+				continue;
+			}
+			w->rc = -1;
+			break;
+		}
+		w->pos += nwr;
+		z -= nwr;
+		if (bp != NULL) {
+			bp += nwr;
+		}
+	}
+	return;
+}
+
+static void
+ipc_pad(struct arrow_ipc_s *w)
+{
+	ipc_put(w, NULL, (size_t)(-w->pos & 7));
+	return;
+}
+
+static size_t
+ipc_schema(struct arrow_ipc_s *w)
+{
+/* write the schema table into W's flatbuffer */
+	struct fb_s *fb = &w->fb;
+	const bool bigp = __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+	size_t at[FB_MAXF], vf;
+	size_t sch;
+
+	sch = fb_table(fb, (const struct fbf_s[]){
+			{bigp ? FB_U16 : FB_NONE, 1U}, {FB_REF, 0U}}, 2U, at);
+	fb_ref(fb, at[1U], vf = fb_vec(fb, w->ncol, 4U));
+	fb_put(fb, NULL, 4U * w->ncol, 4U);
+	for (size_t i = 0U; i < w->ncol; i++) {
+		const bool dp = DICTP(w->dictp, i);
+		size_t fat[FB_MAXF];
+		size_t x;
+
+		/* name, nullable, type, dictionary, children */
+		x = fb_table(fb, (const struct fbf_s[]){
+				{FB_REF, 0U}, {FB_U8, 1U},
+				{FB_U8, TYPE_UTF8}, {FB_REF, 0U},
+				{dp ? FB_REF : FB_NONE, 0U}, {FB_REF, 0U}}, 6U, fat);
+		fb_ref(fb, vf + 4U + 4U * i, x);
+		fb_ref(fb, fat[0U], fb_str(fb, w->names[i]));
+		fb_ref(fb, fat[3U], fb_table(fb, NULL, 0U, NULL));
+		if (dp) {
+			size_t dat[FB_MAXF];
+
+			/* id, index type */
+			x = fb_table(fb, (const struct fbf_s[]){
+					{FB_U64, i}, {FB_REF, 0U}}, 2U, dat);
+			fb_ref(fb, fat[4U], x);
+			/* bit width, signedness */
+			x = fb_table(fb, (const struct fbf_s[]){
+					{FB_U32, 32U}, {FB_U8, 1U}}, 2U, NULL);
+			fb_ref(fb, dat[1U], x);
+		}
+		fb_ref(fb, fat[5U], fb_vec(fb, 0U, 4U));
+	}
+	return sch;
+}
+
+static size_t
+ipc_batch(struct arrow_ipc_s *w, size_t len, const struct inod_s *nod,
+	  size_t nnod, const struct ibuf_s *buf, size_t nbuf)
+{
+/* write a record batch table of LEN rows with field nodes NOD and
+ * buffers BUF into W's flatbuffer, buffers are laid out back to back */
+	struct fb_s *fb = &w->fb;
+	size_t at[FB_MAXF], bat, bo = 0U;
+
+	/* length, nodes, buffers */
+	bat = fb_table(fb, (const struct fbf_s[]){
+			{FB_U64, len}, {FB_REF, 0U}, {FB_REF, 0U}}, 3U, at);
+	fb_ref(fb, at[1U], fb_vec(fb, nnod, 8U));
+	for (size_t i = 0U; i < nnod; i++) {
+		unsigned char x[16U];
+
+		le_put(x, nod[i].len, 8U);
+		le_put(x + 8U, nod[i].nnull, 8U);
+		fb_put(fb, x, sizeof(x), 1U);
+	}
+	fb_ref(fb, at[2U], fb_vec(fb, nbuf, 8U));
+	for (size_t i = 0U; i < nbuf; i++) {
+		unsigned char x[16U];
+
+		le_put(x, bo, 8U);
+		le_put(x + 8U, buf[i].z, 8U);
+		fb_put(fb, x, sizeof(x), 1U);
+		bo += (buf[i].z + 7U) & ~(size_t)7U;
+	}
+	return bat;
+}
+
+static int
+ipc_msg(struct arrow_ipc_s *w, unsigned int typ, int64_t id, size_t len,
+	const struct inod_s *nod, size_t nnod,
+	const struct ibuf_s *buf, size_t nbuf, struct blk_s *blk)
+{
+/* write an encapsulated message with header TYP, for record batches
+ * and dictionaries (of id ID) followed by the buffers BUF as body */
+	struct fb_s *fb = &w->fb;
+	size_t at[FB_MAXF], mz, bz = 0U;
+	unsigned char pre[8U];
+
+	for (size_t i = 0U; i < nbuf; i++) {
+		bz += (buf[i].z + 7U) & ~(size_t)7U;
+	}
+	fb->n = 0U;
+	fb->rc = 0;
+	fb_put(fb, NULL, 4U, 4U);
+	/* version, header type, header, body length */
+	fb_ref(fb, 0U, fb_table(fb, (const struct fbf_s[]){
+				{FB_U16, IPC_V5}, {FB_U8, typ}, {FB_REF, 0U},
+				{FB_U64, bz}}, 4U, at));
+	if (typ == HDR_SCHEMA) {
+		fb_ref(fb, at[2U], ipc_schema(w));
+	} else if (typ == HDR_BATCH) {
+		fb_ref(fb, at[2U], ipc_batch(w, len, nod, nnod, buf, nbuf));
+	} else {
+		size_t dat[FB_MAXF];
+
+		/* id, data */
+		fb_ref(fb, at[2U], fb_table(fb, (const struct fbf_s[]){
+					{FB_U64, (uint64_t)id}, {FB_REF, 0U}},
+				2U, dat));
+		fb_ref(fb, dat[1U], ipc_batch(w, len, nod, nnod, buf, nbuf));
+	}
+	if (UNLIKELY(fb->rc < 0)) {
+		return -1;
+	}
+	mz = (fb->n + 7U) & ~(size_t)7U;
+
+	/* continuation marker, metadata length, metadata, body */
+	*blk = (struct blk_s){w->pos, (int32_t)(mz + sizeof(pre)), (int64_t)bz};
+	le_put(pre, 0xffffffffU, 4U);
+	le_put(pre + 4U, mz, 4U);
+	ipc_put(w, pre, sizeof(pre));
+	ipc_put(w, fb->b, fb->n);
+	ipc_pad(w);
+	for (size_t i = 0U; i < nbuf; i++) {
+		ipc_put(w, buf[i].p, buf[i].z);
+		ipc_pad(w);
+	}
+	return w->rc;
+}
+
+static int
+ipc_dict(struct arrow_ipc_s *w, size_t i)
+{
+/* write the dictionary of column I */
+	static const int32_t nil;
+	const struct idict_s *d = w->dict + i;
+	const struct inod_s nod = {d->n, 0U};
+	const struct ibuf_s buf[] = {
+		{NULL, 0U},
+		{d->off != NULL ? d->off : &nil, (d->n + 1U) * sizeof(*d->off)},
+		{d->dat, d->off != NULL ? (size_t)d->off[d->n] : 0U},
+	};
+	struct blk_s blk;
+
+	if (UNLIKELY(ipc_msg(w, HDR_DICT, (int64_t)i, d->n,
+			     &nod, 1U, buf, countof(buf), &blk) < 0 ||
+		     grow(&w->dblk, &w->zdblk, w->ndblk + 1U,
+			  sizeof(*w->dblk)) < 0)) {
+		return -1;
+	}
+	w->dblk[w->ndblk++] = blk;
+	return 0;
+}
+
+static size_t
+ipc_blocks(struct fb_s *fb, const struct blk_s *blk, size_t n)
+{
+	const size_t at = fb_vec(fb, n, 8U);
+
+	for (size_t i = 0U; i < n; i++) {
+		unsigned char x[24U] = {0U};
+
+		le_put(x, (uint64_t)blk[i].off, 8U);
+		le_put(x + 8U, (uint64_t)blk[i].mlen, 4U);
+		le_put(x + 16U, (uint64_t)blk[i].blen, 8U);
+		fb_put(fb, x, sizeof(x), 1U);
+	}
+	return at;
+}
+
+
+/* public API */
+arrow_t
+make_arrow(const char *const *names, size_t ncol, uint64_t dict)
+{
+	struct arrow_s *a = calloc(1U, sizeof(*a) + ncol * sizeof(*a->col));
+
+	if (UNLIKELY(a == NULL)) {
+		return NULL;
+	}
+	a->names = names;
+	a->ncol = ncol;
+	a->dictp = dict;
+	for (size_t i = 0U; i < ncol; i++) {
+		if (DICTP(dict, i) &&
+		    UNLIKELY((a->col[i].dict = make_dict()) == NULL)) {
+			free_arrow(a);
+			return NULL;
+		}
+	}
+	return a;
+}
+
+void
+free_arrow(arrow_t a)
+{
+	for (size_t i = 0U; i < a->ncol; i++) {
+		free(a->col[i].vld);
+		free(a->col[i].off);
+		free(a->col[i].dat);
+		free_dict(a->col[i].dict);
+	}
+	free(a);
+	return;
+}
+
+ssize_t
+arrow_add(arrow_t a, const char *const *v, const size_t *z)
+{
+	const size_t n = a->n;
+
+	if (UNLIKELY(n + 1U >= a->zrow)) {
+		const size_t nz = a->zrow ? 2U * a->zrow : ROWS_INI;
+
+		for (size_t i = 0U; i < a->ncol; i++) {
+			struct col_s *c = a->col + i;
+			size_t zv = a->zrow / 8U, zo = a->zrow + !!a->zrow;
+
+			if (UNLIKELY(grow(&c->vld, &zv, nz / 8U, 1U) < 0 ||
+				     grow(&c->off, &zo, nz + 1U,
+					  sizeof(*c->off)) < 0)) {
+				return -1;
+			}
+		}
+		a->zrow = nz;
+	}
+	for (size_t i = 0U; i < a->ncol; i++) {
+		struct col_s *c = a->col + i;
+		int32_t x;
+
+		if (v[i] == NULL) {
+			c->nnull++;
+			x = c->dict == NULL ? (int32_t)c->ndat : 0;
+		} else if (c->dict != NULL) {
+			if (UNLIKELY((x = dict_id(c->dict, v[i], z[i])) < 0)) {
+				goto undo;
+			}
+			c->vld[n / 8U] |= (uint8_t)(1U << n % 8U);
+		} else if (UNLIKELY(c->ndat + z[i] > INT32_MAX ||
+				    grow(&c->dat, &c->zdat,
+					 c->ndat + z[i], 1U) < 0)) {
+			goto undo;
+		} else {
+			memcpy(c->dat + c->ndat, v[i], z[i]);
+			c->ndat += z[i];
+			x = (int32_t)c->ndat;
+			c->vld[n / 8U] |= (uint8_t)(1U << n % 8U);
+		}
+		c->off[n + (c->dict == NULL)] = x;
+		continue;
+
+	undo:
+		/* forget the columns done so far */
+		for (size_t j = 0U; j < i; j++) {
+			c = a->col + j;
+			c->vld[n / 8U] &= (uint8_t)~(1U << n % 8U);
+			c->nnull -= v[j] == NULL;
+			c->ndat = c->dict == NULL ? (size_t)c->off[n] : 0U;
+		}
+		return -1;
+	}
+	return (ssize_t)++a->n;
+}
+
+int
+arrow_schema(arrow_t a, struct ArrowSchema *s)
+{
+	struct xsch_s *x = make_xsch("+s", "", 0, a->ncol);
+
+	if (UNLIKELY(x == NULL)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < a->ncol; i++) {
+		const bool dp = DICTP(a->dictp, i);
+		struct xsch_s *c, *d = NULL;
+
+		c = make_xsch(dp ? "i" : "u", a->names[i],
+			      ARROW_FLAG_NULLABLE, 0U);
+		if (UNLIKELY(c == NULL) ||
+		    (dp && UNLIKELY((d = make_xsch("u", "", 0, 0U)) == NULL))) {
+			free(c);
+			xsch_release(&x->s);
+			return -1;
+		}
+		c->s.dictionary = d != NULL ? &d->s : NULL;
+		x->chld[i] = &c->s;
+	}
+	/* move to the consumer's */
+	*s = x->s;
+	return 0;
+}
+
+int
+arrow_batch(arrow_t a, struct ArrowArray *arr)
+{
+	struct xtop_s *top = calloc(1U, sizeof(*top) + a->ncol * sizeof(*top->chld));
+	struct ArrowArray **chld;
+
+	if (UNLIKELY(top == NULL)) {
+		return -1;
+	}
+	chld = top->chld;
+	*arr = (struct ArrowArray){
+		.length = (int64_t)a->n,
+		.n_buffers = 1,
+		.n_children = (int64_t)a->ncol,
+		.buffers = top->buf,
+		.children = chld,
+		.release = top_release,
+		.private_data = top,
+	};
+	for (size_t i = 0U; i < a->ncol; i++) {
+		struct col_s *c = a->col + i;
+		struct ArrowArray *x;
+		struct xarr_s *xp;
+
+		/* even empty batches have an offset and a data buffer */
+		if (UNLIKELY((c->off == NULL &&
+			      (c->off = calloc(1U, sizeof(*c->off))) == NULL) ||
+			     (c->dict == NULL &&
+			      grow(&c->dat, &c->zdat, 1U, 1U) < 0))) {
+			goto nope;
+		}
+		x = make_xarr(a->n, c->nnull, c->dict == NULL ? 3U : 2U);
+		if (UNLIKELY(x == NULL)) {
+			goto nope;
+		}
+		chld[i] = x;
+		if (c->dict != NULL &&
+		    UNLIKELY((x->dictionary = dict_export(c->dict)) == NULL)) {
+			goto nope;
+		}
+		/* hand over the buffers */
+		xp = x->private_data;
+		xp->buf[0U] = c->nnull ? c->vld : NULL;
+		xp->buf[1U] = xp->mem[1U] = c->off;
+		xp->buf[2U] = xp->mem[2U] = c->dat;
+		xp->mem[0U] = c->vld;
+		*c = (struct col_s){.dict = c->dict};
+	}
+	a->n = 0U;
+	a->zrow = 0U;
+	return 0;
+
+nope:
+	top_release(arr);
+	return -1;
+}
+
+arrow_ipc_t
+make_arrow_ipc(int fd, const struct ArrowSchema *s)
+{
+	struct arrow_ipc_s *w;
+	struct blk_s blk;
+
+	if (UNLIKELY(strcmp(s->format, "+s"))) {
+		return NULL;
+	}
+	for (int64_t i = 0; i < s->n_children; i++) {
+		const struct ArrowSchema *c = s->children[i];
+
+		if (!strcmp(c->format, "u") && c->dictionary == NULL) {
+			continue;
+		} else if (!strcmp(c->format, "i") && c->dictionary != NULL &&
+			   !strcmp(c->dictionary->format, "u") && i < 64) {
+			continue;
+		}
+		/* can't do anything else */
+		return NULL;
+	}
+	if (UNLIKELY((w = calloc(1U, sizeof(*w))) == NULL)) {
+		return NULL;
+	}
+	w->fd = fd;
+	w->ncol = (size_t)s->n_children;
+	w->names = calloc(w->ncol, sizeof(*w->names));
+	w->dict = calloc(w->ncol, sizeof(*w->dict));
+	if (UNLIKELY(w->names == NULL || w->dict == NULL)) {
+		goto nope;
+	}
+	for (size_t i = 0U; i < w->ncol; i++) {
+		const struct ArrowSchema *c = s->children[i];
+
+		w->names[i] = strdup(c->name != NULL ? c->name : "");
+		if (UNLIKELY(w->names[i] == NULL)) {
+			goto nope;
+		}
+		w->dictp |= (uint64_t)(c->dictionary != NULL) << i;
+	}
+
+	/* magic, then the schema message */
+	ipc_put(w, ipc_magic, sizeof(ipc_magic));
+	if (UNLIKELY(ipc_msg(w, HDR_SCHEMA, 0, 0U, NULL, 0U, NULL, 0U, &blk) < 0)) {
+		goto nope;
+	}
+	return w;
+
+nope:
+	free_arrow_ipc(w);
+	return NULL;
+}
+
+void
+free_arrow_ipc(arrow_ipc_t w)
+{
+	for (size_t i = 0U; i < w->ncol; i++) {
+		if (w->names != NULL) {
+			free(w->names[i]);
+		}
+		if (w->dict != NULL) {
+			free(w->dict[i].off);
+			free(w->dict[i].dat);
+		}
+	}
+	free(w->names);
+	free(w->dict);
+	free(w->bat);
+	free(w->dblk);
+	free(w->fb.b);
+	free(w);
+	return;
+}
+
+int
+arrow_ipc_write(arrow_ipc_t w, const struct ArrowArray *arr)
+{
+	const size_t len = (size_t)arr->length;
+	struct inod_s *nod;
+	struct ibuf_s *buf;
+	size_t nbuf = 0U;
+	struct blk_s blk;
+	int rc = -1;
+
+	if (UNLIKELY((size_t)arr->n_children != w->ncol || arr->offset)) {
+		return -1;
+	}
+	nod = calloc(w->ncol, sizeof(*nod));
+	buf = calloc(3U * w->ncol, sizeof(*buf));
+	if (UNLIKELY(nod == NULL || buf == NULL)) {
+		goto out;
+	}
+	for (size_t i = 0U; i < w->ncol; i++) {
+		const struct ArrowArray *c = arr->children[i];
+		const size_t nnull = (size_t)c->null_count;
+
+		if (UNLIKELY((size_t)c->length != len || c->offset)) {
+			goto out;
+		}
+		nod[i] = (struct inod_s){len, nnull};
+		buf[nbuf++] = (struct ibuf_s){
+			c->buffers[0U], nnull ? (len + 7U) / 8U : 0U
+		};
+		if (!DICTP(w->dictp, i)) {
+			const int32_t *off = c->buffers[1U];
+
+			buf[nbuf++] = (struct ibuf_s){off, (len + 1U) * 4U};
+			buf[nbuf++] = (struct ibuf_s){c->buffers[2U], off[len]};
+			continue;
+		}
+		/* indices, keep the dictionary if it's grown */
+		buf[nbuf++] = (struct ibuf_s){c->buffers[1U], len * 4U};
+		if ((size_t)c->dictionary->length > w->dict[i].n) {
+			const struct ArrowArray *d = c->dictionary;
+			const size_t n = (size_t)d->length;
+			const int32_t *off = d->buffers[1U];
+			struct idict_s x = {
+				malloc((n + 1U) * sizeof(*off)),
+				malloc(off[n] + 1U),
+				n,
+			};
+
+			if (UNLIKELY(x.off == NULL || x.dat == NULL)) {
+				free(x.off);
+				free(x.dat);
+				goto out;
+			}
+			memcpy(x.off, off, (n + 1U) * sizeof(*off));
+			memcpy(x.dat, d->buffers[2U], off[n]);
+			free(w->dict[i].off);
+			free(w->dict[i].dat);
+			w->dict[i] = x;
+		}
+	}
+	if (UNLIKELY(grow(&w->bat, &w->zbat, w->nbat + 1U, sizeof(*w->bat)) < 0 ||
+		     ipc_msg(w, HDR_BATCH, 0, len,
+			     nod, w->ncol, buf, nbuf, &blk) < 0)) {
+		goto out;
+	}
+	w->bat[w->nbat++] = blk;
+	rc = 0;
+
+out:
+	free(nod);
+	free(buf);
+	return rc;
+}
+
+int
+arrow_ipc_fin(arrow_ipc_t w)
+{
+	struct fb_s *fb = &w->fb;
+	size_t at[FB_MAXF];
+	unsigned char eos[8U], fz[4U];
+
+	/* dictionaries may come after the batches using them */
+	for (size_t i = 0U; i < w->ncol; i++) {
+		if (DICTP(w->dictp, i) && UNLIKELY(ipc_dict(w, i) < 0)) {
+			return -1;
+		}
+	}
+	le_put(eos, 0xffffffffU, 4U);
+	le_put(eos + 4U, 0U, 4U);
+	ipc_put(w, eos, sizeof(eos));
+
+	/* footer: version, schema, dictionaries, record batches */
+	fb->n = 0U;
+	fb->rc = 0;
+	fb_put(fb, NULL, 4U, 4U);
+	fb_ref(fb, 0U, fb_table(fb, (const struct fbf_s[]){
+				{FB_U16, IPC_V5}, {FB_REF, 0U},
+				{FB_REF, 0U}, {FB_REF, 0U}}, 4U, at));
+	fb_ref(fb, at[1U], ipc_schema(w));
+	fb_ref(fb, at[2U], ipc_blocks(fb, w->dblk, w->ndblk));
+	fb_ref(fb, at[3U], ipc_blocks(fb, w->bat, w->nbat));
+	if (UNLIKELY(fb->rc < 0)) {
+		return -1;
+	}
+	le_put(fz, fb->n, 4U);
+	ipc_put(w, fb->b, fb->n);
+	ipc_put(w, fz, sizeof(fz));
+	ipc_put(w, ipc_magic, 6U);
+	return w->rc;
+}
+
+/* arrow.c ends here */
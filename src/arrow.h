@@ -0,0 +1,146 @@
+/*** arrow.h -- Arrow C data interface and IPC file writer
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if !defined INCLUDED_arrow_h_
+#define INCLUDED_arrow_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#if !defined ARROW_C_DATA_INTERFACE
+/* the Arrow C data interface, verbatim from its specification */
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED	1
+#define ARROW_FLAG_NULLABLE		2
+#define ARROW_FLAG_MAP_KEYS_SORTED	4
+
+struct ArrowSchema {
+	/* array type description */
+	const char *format;
+	const char *name;
+	const char *metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema **children;
+	struct ArrowSchema *dictionary;
+
+	/* release callback */
+	void (*release)(struct ArrowSchema*);
+	/* opaque producer-specific data */
+	void *private_data;
+};
+
+struct ArrowArray {
+	/* array data description */
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void **buffers;
+	struct ArrowArray **children;
+	struct ArrowArray *dictionary;
+
+	/* release callback */
+	void (*release)(struct ArrowArray*);
+	/* opaque producer-specific data */
+	void *private_data;
+};
+#endif	/* ARROW_C_DATA_INTERFACE */
+
+typedef struct arrow_s *arrow_t;
+typedef struct arrow_ipc_s *arrow_ipc_t;
+
+/**
+ * Return a builder for record batches of NCOL nullable utf8 columns
+ * named NAMES.  Columns whose bit is set in DICT are dictionary-encoded
+ * with int32 indices, their dictionaries are shared by all batches and
+ * only ever grow, i.e. a batch's dictionary extends the previous one's.
+ * NAMES must stay valid while the builder and its exports live. */
+extern arrow_t make_arrow(const char *const *names, size_t ncol, uint64_t dict);
+
+/**
+ * Free resources associated with A.
+ * Schemas and batches exported from A stay valid. */
+extern void free_arrow(arrow_t a);
+
+/**
+ * Append a row to A's current batch, V[i] of length Z[i] being the
+ * value of column i or NULL for null.
+ * A must not be used from several threads at the same time.
+ * Return the number of rows in the current batch, or -1 on failure. */
+extern ssize_t arrow_add(arrow_t a, const char *const *v, const size_t *z);
+
+/**
+ * Export A's schema, a struct of its columns, into S.
+ * S is to be released by the consumer.
+ * Return 0 on success, -1 otherwise. */
+extern int arrow_schema(arrow_t a, struct ArrowSchema *s);
+
+/**
+ * Move the rows added to A so far into ARR, a struct array matching
+ * A's schema, and start a new batch.
+ * ARR is to be released by the consumer.
+ * Return 0 on success, -1 otherwise. */
+extern int arrow_batch(arrow_t a, struct ArrowArray *arr);
+
+/**
+ * Return a writer of an Arrow IPC file with schema S to FD.
+ * S has to be a struct of utf8 columns or of int32-indexed dictionaries
+ * of utf8, as exported by arrow_schema().
+ * The magic and the schema are written right away. */
+extern arrow_ipc_t make_arrow_ipc(int fd, const struct ArrowSchema *s);
+
+/**
+ * Write ARR, a struct array matching W's schema, as record batch.
+ * Dictionaries of consecutive batches must extend one another, as
+ * they do for batches from arrow_batch(), the largest is written by
+ * arrow_ipc_fin().  ARR is not released.
+ * Return 0 on success, -1 otherwise. */
+extern int arrow_ipc_write(arrow_ipc_t w, const struct ArrowArray *arr);
+
+/**
+ * Write W's dictionaries and the file footer.
+ * Return 0 on success, -1 if anything written to W failed. */
+extern int arrow_ipc_fin(arrow_ipc_t w);
+
+/**
+ * Free resources associated with W. */
+extern void free_arrow_ipc(arrow_ipc_t w);
+
+#endif	/* INCLUDED_arrow_h_ */
@@ -0,0 +1,737 @@
+/*** cdftok.c -- tokeniser for LEI-CDF files
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+# include <immintrin.h>
+# define HAVE_X86_SIMD
+#endif	/* __GNUC__ && x86 */
+#include "cdftok.h"
+#include "entdec.h"
+
+#if !defined LIKELY
+# define LIKELY(_x)	__builtin_expect((_x), 1)
+#endif
+#if !defined UNLIKELY
+# define UNLIKELY(_x)	__builtin_expect((_x), 0)
+#endif
+#define countof(_x)	(sizeof(_x) / sizeof(*_x))
+#define strlenof(_x)	(sizeof(_x) - 1U)
+
+/* maximum number of attributes per element we keep track of */
+#define NATTS	(16U)
+/* maximum element nesting */
+#define NDEPTH	(64U)
+/* maximum number of namespace declarations in scope */
+#define NNS	(32U)
+
+
+static const char*
+xmemmem(const char *hay, const size_t hz, const char *ndl, const size_t nz)
+{
+	const char *const eoh = hay + hz - nz + 1U;
+
+	if (UNLIKELY(nz == 0U || hz < nz)) {
+		return NULL;
+	}
+	for (const char *hp = hay;
+	     (hp = memchr(hp, *ndl, eoh - hp)) != NULL; hp++) {
+		if (!memcmp(hp, ndl, nz)) {
+			return hp;
+		}
+	}
+	return NULL;
+}
+
+static inline __attribute__((const)) bool
+ws_p(char c)
+{
+	switch (c) {
+	case ' ':
+	case '\t':
+	case '\n':
+	case '\r':
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+static const char*
+skip_ws(const char *bp, const char *ep)
+{
+	for (; bp < ep && ws_p(*bp); bp++);
+	return bp;
+}
+
+
+/* text scanners, return pointer to next '<', '&' or '\r', or EP */
+static const char*
+scan_text_scalar(const char *bp, const char *ep)
+{
+	for (; bp < ep; bp++) {
+		switch (*bp) {
+		case '<':
+		case '&':
+		case '\r':
+			return bp;
+		default:
+			break;
+		}
+	}
+	return ep;
+}
+
+#if defined HAVE_X86_SIMD
+static __attribute__((target("sse4.2"))) const char*
+scan_text_sse42(const char *bp, const char *ep)
+{
+	const __m128i set = _mm_setr_epi8(
+		'<', '&', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+	for (; bp + 16U <= ep; bp += 16U) {
+		const __m128i x = _mm_loadu_si128((const void*)bp);
+		const int i = _mm_cmpestri(
+			set, 3, x, 16,
+			_SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY |
+			_SIDD_LEAST_SIGNIFICANT);
+
+		if (i < 16) {
+			return bp + i;
+		}
+	}
+	return scan_text_scalar(bp, ep);
+}
+
+static __attribute__((target("avx2"))) const char*
+scan_text_avx2(const char *bp, const char *ep)
+{
+	const __m256i lt = _mm256_set1_epi8('<');
+	const __m256i am = _mm256_set1_epi8('&');
+	const __m256i cr = _mm256_set1_epi8('\r');
+
+	for (; bp + 32U <= ep; bp += 32U) {
+		const __m256i x = _mm256_loadu_si256((const void*)bp);
+		const __m256i m = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(x, lt),
+				_mm256_cmpeq_epi8(x, am)),
+			_mm256_cmpeq_epi8(x, cr));
+		const unsigned int b = (unsigned int)_mm256_movemask_epi8(m);
+
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return scan_text_sse42(bp, ep);
+}
+#endif	/* HAVE_X86_SIMD */
+
+static const char *(*scan_text)(const char*, const char*) = scan_text_scalar;
+
+static void __attribute__((constructor))
+scan_init(void)
+{
+#if defined HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		scan_text = scan_text_avx2;
+	} else if (__builtin_cpu_supports("sse4.2")) {
+		scan_text = scan_text_sse42;
+	}
+#endif	/* HAVE_X86_SIMD */
+	return;
+}
+
+
+/* markup */
+/* tokeniser state */
+struct cdftok_s {
+	const xmlSAXHandler *hdl;
+	void *ctx;
+	xmlDictPtr dict;
+
+	/* open elements */
+	size_t depth;
+	struct {
+		const xmlChar *loc;
+		const xmlChar *pre;
+		const xmlChar *uri;
+		size_t locz;
+		size_t prez;
+	} el[NDEPTH];
+
+	/* namespace declarations in scope */
+	size_t nns;
+	struct {
+		const xmlChar *pre;
+		const xmlChar *uri;
+		size_t depth;
+	} ns[NNS];
+
+	/* set by cdftok_skip() from within startElementNs */
+	bool skipp;
+	/* set once the root element is closed */
+	bool rootp;
+	/* just past the tag whose event is being raised */
+	const char *at;
+};
+
+static inline const xmlChar*
+tok_intern(cdftok_t t, const char *s, size_t z)
+{
+	return xmlDictLookup(t->dict, (const xmlChar*)s, (int)z);
+}
+
+static const xmlChar*
+tok_nsuri(cdftok_t t, const xmlChar *pre)
+{
+	for (size_t i = t->nns; i > 0U; i--) {
+		if (t->ns[i - 1U].pre == pre) {
+			return t->ns[i - 1U].uri;
+		}
+	}
+	return NULL;
+}
+
+static const char*
+tok_name(const char *bp, const char *ep)
+{
+/* return a pointer past the name at BP */
+	const char *np;
+
+	for (np = bp; np < ep; np++) {
+		switch (*np) {
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+		case '/':
+		case '>':
+		case '=':
+			goto out;
+		default:
+			break;
+		}
+	}
+	/* premature end */
+	return NULL;
+out:
+	return np > bp ? np : NULL;
+}
+
+static void
+tok_qname(cdftok_t t, const xmlChar **loc, const xmlChar **pre,
+	  const char *bp, const char *np)
+{
+/* split qualified name BP..NP into interned local name and prefix */
+	const char *cp = memchr(bp, ':', np - bp);
+
+	if (cp == NULL) {
+		*pre = NULL;
+		*loc = tok_intern(t, bp, np - bp);
+		return;
+	}
+	*pre = tok_intern(t, bp, cp - bp);
+	*loc = tok_intern(t, cp + 1U, np - cp - 1U);
+	return;
+}
+
+static const char *tok_etag(cdftok_t t, const char *bp, const char *ep);
+
+static const char*
+tok_skip(cdftok_t t, const char *bp, const char *ep)
+{
+/* BP points past the start tag of the innermost open element,
+ * jump over its content without raising events and consume its
+ * end tag, only nesting is tracked */
+	for (size_t n = 1U; (bp = memchr(bp, '<', ep - bp)) != NULL;) {
+		const char *tp;
+
+		if (UNLIKELY(++bp >= ep)) {
+			break;
+		}
+		switch (*bp) {
+		case '/':
+			if (!--n) {
+				return tok_etag(t, bp + 1U, ep);
+			}
+			tp = memchr(bp, '>', ep - bp);
+			break;
+		case '?':
+			tp = xmemmem(bp, ep - bp, "?>", 2U);
+			break;
+		case '!':
+			if (ep - bp >= 3 && !memcmp(bp, "!--", 3U)) {
+				tp = xmemmem(bp + 3U, ep - bp - 3U, "-->", 3U);
+			} else {
+				tp = xmemmem(bp, ep - bp, "]]>", 3U);
+			}
+			break;
+		default:
+			/* start tag, mind quoted attribute values */
+			for (tp = bp; tp < ep && *tp != '>'; tp++) {
+				if (*tp == '"' || *tp == '\'') {
+					tp = memchr(tp + 1U, *tp, ep - tp - 1U);
+					if (UNLIKELY(tp == NULL)) {
+						return NULL;
+					}
+				}
+			}
+			if (UNLIKELY(tp >= ep)) {
+				return NULL;
+			}
+			n += tp[-1] != '/';
+			break;
+		}
+		if (UNLIKELY(tp == NULL)) {
+			break;
+		}
+		bp = tp + 1U;
+	}
+	return NULL;
+}
+
+static const char*
+tok_stag(cdftok_t t, const char *bp, const char *ep)
+{
+/* BP points just past the '<' of a start tag */
+	static const char xmlns[] = "xmlns";
+	/* raw attributes */
+	struct {
+		const char *nb, *ne;
+		const char *vb, *ve;
+	} ra[NATTS];
+	const xmlChar *atts[5U * NATTS];
+	const xmlChar *nsd[2U * NNS];
+	char ab[2048U];
+	size_t na = 0U;
+	size_t nd = 0U;
+	size_t ai = 0U;
+	const xmlChar *loc, *pre, *uri;
+	const char *np;
+	bool emptyp = false;
+
+	if (UNLIKELY(t->depth >= NDEPTH)) {
+		return NULL;
+	} else if (UNLIKELY(!t->depth && t->rootp)) {
+		/* a second root element */
+		return NULL;
+	} else if (UNLIKELY((np = tok_name(bp, ep)) == NULL)) {
+		return NULL;
+	}
+	tok_qname(t, &loc, &pre, bp, np);
+	t->el[t->depth].locz = strlen((const char*)loc);
+	t->el[t->depth].prez = pre ? strlen((const char*)pre) : 0U;
+
+	/* snarf attributes */
+	for (bp = np; (bp = skip_ws(bp, ep)) < ep;) {
+		const char *vp;
+
+		switch (*bp) {
+		case '/':
+			if (UNLIKELY(++bp >= ep || *bp != '>')) {
+				return NULL;
+			}
+			emptyp = true;
+			/* fallthrough */
+		case '>':
+			bp++;
+			goto eot;
+		default:
+			break;
+		}
+		/* attribute then */
+		if (UNLIKELY(na >= NATTS)) {
+			return NULL;
+		} else if (UNLIKELY((np = tok_name(bp, ep)) == NULL)) {
+			return NULL;
+		}
+		ra[na].nb = bp;
+		ra[na].ne = np;
+
+		if (UNLIKELY((bp = skip_ws(np, ep)) >= ep || *bp != '=')) {
+			return NULL;
+		} else if (UNLIKELY((bp = skip_ws(bp + 1U, ep)) >= ep)) {
+			return NULL;
+		} else if (UNLIKELY(*bp != '"' && *bp != '\'')) {
+			return NULL;
+		} else if ((vp = memchr(bp + 1U, *bp, ep - bp - 1U)) == NULL) {
+			return NULL;
+		}
+		ra[na].vb = bp + 1U;
+		ra[na].ve = vp;
+		bp = vp + 1U;
+
+		/* namespace declarations go on the stack straight away */
+		if (np - ra[na].nb >= (ptrdiff_t)strlenof(xmlns) &&
+		    !memcmp(ra[na].nb, xmlns, strlenof(xmlns)) &&
+		    (np - ra[na].nb == (ptrdiff_t)strlenof(xmlns) ||
+		     ra[na].nb[strlenof(xmlns)] == ':')) {
+			const char *pb = ra[na].nb + strlenof(xmlns) + 1U;
+
+			if (UNLIKELY(t->nns >= NNS)) {
+				return NULL;
+			}
+			t->ns[t->nns].pre = pb < np
+				? tok_intern(t, pb, np - pb) : NULL;
+			t->ns[t->nns].uri = tok_intern(
+				t, ra[na].vb, ra[na].ve - ra[na].vb);
+			t->ns[t->nns].depth = t->depth;
+			nsd[nd++] = t->ns[t->nns].pre;
+			nsd[nd++] = t->ns[t->nns].uri;
+			t->nns++;
+			continue;
+		}
+		na++;
+	}
+	return NULL;
+
+eot:
+	uri = tok_nsuri(t, pre);
+
+	/* resolve attributes */
+	for (size_t i = 0U; i < na; i++) {
+		const xmlChar **a = atts + 5U * i;
+
+		tok_qname(t, a + 0U, a + 1U, ra[i].nb, ra[i].ne);
+		/* unprefixed attributes are in no namespace */
+		a[2U] = a[1U] ? tok_nsuri(t, a[1U]) : NULL;
+
+		if (memchr(ra[i].vb, '&', ra[i].ve - ra[i].vb) == NULL) {
+			/* straight from the input */
+			a[3U] = (const xmlChar*)ra[i].vb;
+			a[4U] = (const xmlChar*)ra[i].ve;
+			continue;
+		}
+		/* decode into the attribute buffer */
+		a[3U] = (const xmlChar*)ab + ai;
+		for (const char *vp = ra[i].vb; vp < ra[i].ve; vp++) {
+			if (UNLIKELY(ai + 4U >= sizeof(ab))) {
+				return NULL;
+			} else if (LIKELY(*vp != '&')) {
+				ab[ai++] = *vp;
+			} else {
+				const char *on;
+				size_t z = ent_dec(ab + ai, vp, ra[i].ve, &on);
+
+				if (UNLIKELY(!z)) {
+					return NULL;
+				}
+				ai += z;
+				vp = on - 1;
+			}
+		}
+		a[4U] = (const xmlChar*)ab + ai;
+	}
+
+	t->skipp = false;
+	t->at = bp;
+	t->hdl->startElementNs(
+		t->ctx, loc, pre, uri,
+		(int)(nd / 2U), nsd, (int)na, 0, atts);
+	if (emptyp) {
+		t->hdl->endElementNs(t->ctx, loc, pre, uri);
+		/* pop namespaces declared on this element */
+		for (; t->nns > 0U && t->ns[t->nns - 1U].depth >= t->depth;
+		     t->nns--);
+		t->rootp = !t->depth;
+		return bp;
+	}
+	t->el[t->depth].loc = loc;
+	t->el[t->depth].pre = pre;
+	t->el[t->depth].uri = uri;
+	t->depth++;
+	if (t->skipp) {
+		return tok_skip(t, bp, ep);
+	}
+	return bp;
+}
+
+static const char*
+tok_etag(cdftok_t t, const char *bp, const char *ep)
+{
+/* BP points just past the '</' of an end tag */
+	const char *np;
+	size_t d;
+
+	if (UNLIKELY(!t->depth)) {
+		return NULL;
+	} else if (UNLIKELY((np = tok_name(bp, ep)) == NULL)) {
+		return NULL;
+	}
+	/* check against the innermost open element */
+	d = t->depth - 1U;
+	if (t->el[d].pre) {
+		const size_t pz = t->el[d].prez;
+
+		if (UNLIKELY(np - bp != (ptrdiff_t)(pz + 1U + t->el[d].locz) ||
+			     memcmp(bp, t->el[d].pre, pz) || bp[pz] != ':')) {
+			return NULL;
+		}
+		bp += pz + 1U;
+	}
+	if (UNLIKELY(np - bp != (ptrdiff_t)t->el[d].locz ||
+		     memcmp(bp, t->el[d].loc, np - bp))) {
+		return NULL;
+	} else if (UNLIKELY((np = skip_ws(np, ep)) >= ep || *np != '>')) {
+		return NULL;
+	}
+	t->at = np + 1U;
+	t->hdl->endElementNs(t->ctx, t->el[d].loc, t->el[d].pre, t->el[d].uri);
+	/* pop namespaces declared on this element */
+	for (; t->nns > 0U && t->ns[t->nns - 1U].depth >= d; t->nns--);
+	t->depth = d;
+	t->rootp = !d;
+	return np + 1U;
+}
+
+static const char*
+tok_mark(cdftok_t t, const char *bp, const char *ep)
+{
+/* BP points to a '<' */
+	static const char cdo[] = "<![CDATA[";
+	const char *tp;
+
+	if (UNLIKELY(bp + 1U >= ep)) {
+		return NULL;
+	}
+	switch (bp[1U]) {
+	case '/':
+		return tok_etag(t, bp + 2U, ep);
+	case '?':
+		/* processing instruction */
+		if (UNLIKELY((tp = xmemmem(bp, ep - bp, "?>", 2U)) == NULL)) {
+			return NULL;
+		}
+		return tp + 2U;
+	case '!':
+		if (ep - bp >= 4 && !memcmp(bp, "<!--", 4U)) {
+			tp = xmemmem(bp + 4U, ep - bp - 4U, "-->", 3U);
+			if (UNLIKELY(tp == NULL)) {
+				return NULL;
+			}
+			return tp + 3U;
+		} else if (ep - bp >= (ptrdiff_t)strlenof(cdo) &&
+			   !memcmp(bp, cdo, strlenof(cdo))) {
+			bp += strlenof(cdo);
+			if ((tp = xmemmem(bp, ep - bp, "]]>", 3U)) == NULL) {
+				return NULL;
+			} else if (tp > bp) {
+				t->hdl->characters(
+					t->ctx, (const xmlChar*)bp, tp - bp);
+			}
+			return tp + 3U;
+		}
+		/* DTDs and friends are beyond us */
+		return NULL;
+	default:
+		break;
+	}
+	return tok_stag(t, bp + 1U, ep);
+}
+
+
+/* public API */
+int
+cdftok_okp(const char *buf, size_t len)
+{
+	const char *bp = buf;
+	const char *const ep = buf + len;
+
+	if (len >= 3U && !memcmp(bp, "\xef\xbb\xbf", 3U)) {
+		bp += 3U;
+	}
+	if (ep - bp >= 5 && !memcmp(bp, "<?xml", 5U)) {
+		const char *eo;
+		const char *enc;
+
+		if ((eo = xmemmem(bp, ep - bp, "?>", 2U)) == NULL) {
+			return 0;
+		}
+		if ((enc = xmemmem(bp, eo - bp, "encoding", 8U)) != NULL) {
+			static const char *const encs[] = {"UTF-8", "US-ASCII"};
+			size_t i;
+
+			if ((enc = skip_ws(enc + 8U, eo)) >= eo || *enc != '=') {
+				return 0;
+			} else if ((enc = skip_ws(enc + 1U, eo)) >= eo) {
+				return 0;
+			} else if (*enc != '"' && *enc != '\'') {
+				return 0;
+			}
+			for (i = 0U, enc++; i < countof(encs); i++) {
+				const size_t z = strlen(encs[i]);
+
+				if (eo - enc > (ptrdiff_t)z &&
+				    !strncasecmp(enc, encs[i], z) &&
+				    enc[z] == enc[-1]) {
+					break;
+				}
+			}
+			if (i >= countof(encs)) {
+				return 0;
+			}
+		}
+		bp = eo + 2U;
+	}
+	/* there must be no DTD before the root element */
+	while ((bp = skip_ws(bp, ep)) + 1U < ep && *bp == '<') {
+		const char *tp;
+
+		if (ep - bp >= 4 && !memcmp(bp, "<!--", 4U)) {
+			tp = xmemmem(bp + 4U, ep - bp - 4U, "-->", 3U);
+			if (tp == NULL) {
+				return 0;
+			}
+			bp = tp + 3U;
+		} else if (bp[1U] == '?') {
+			if ((tp = xmemmem(bp, ep - bp, "?>", 2U)) == NULL) {
+				return 0;
+			}
+			bp = tp + 2U;
+		} else {
+			return bp[1U] != '!';
+		}
+	}
+	return 0;
+}
+
+cdftok_t
+make_cdftok(const xmlSAXHandler *hdl, void *ctx, xmlDictPtr dict)
+{
+	static const char xml[] = "xml";
+	static const char xns[] = "http://www.w3.org/XML/1998/namespace";
+	cdftok_t t;
+
+	if (UNLIKELY((t = calloc(1U, sizeof(*t))) == NULL)) {
+		return NULL;
+	}
+	t->hdl = hdl;
+	t->ctx = ctx;
+	t->dict = dict;
+	/* the xml prefix is always bound */
+	t->ns[0U].pre = tok_intern(t, xml, strlenof(xml));
+	t->ns[0U].uri = tok_intern(t, xns, strlenof(xns));
+	t->nns = 1U;
+	return t;
+}
+
+void
+free_cdftok(cdftok_t t)
+{
+	free(t);
+	return;
+}
+
+void
+cdftok_skip(cdftok_t t)
+{
+	t->skipp = true;
+	return;
+}
+
+int
+cdftok_parse(cdftok_t t, const char *buf, size_t len)
+{
+	const char *bp = buf;
+	const char *const ep = buf + len;
+
+	if (len >= 3U && !memcmp(bp, "\xef\xbb\xbf", 3U)) {
+		bp += 3U;
+	}
+	while (bp < ep) {
+		const char *tp = scan_text(bp, ep);
+
+		if (tp > bp) {
+			t->hdl->characters(t->ctx, (const xmlChar*)bp, tp - bp);
+		}
+		if (tp >= ep) {
+			break;
+		}
+		switch (*tp) {
+		case '<':
+			bp = tok_mark(t, tp, ep);
+			if (UNLIKELY(bp == NULL)) {
+				return -1;
+			}
+			break;
+		case '&': {
+			char c[4U];
+			size_t z = ent_dec(c, tp, ep, &bp);
+
+			if (UNLIKELY(!z)) {
+				return -1;
+			}
+			t->hdl->characters(t->ctx, (const xmlChar*)c, z);
+			break;
+		}
+		case '\r':
+			/* line end normalisation */
+			t->hdl->characters(t->ctx, (const xmlChar*)"\n", 1);
+			bp = tp + 1U;
+			if (bp < ep && *bp == '\n') {
+				bp++;
+			}
+			break;
+		default:
+			/* can't happen */
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int
+cdftok_fin(cdftok_t t)
+{
+	return t->depth || !t->rootp ? -1 : 0;
+}
+
+const char*
+cdftok_at(cdftok_t t)
+{
+	return t->at;
+}
+
+/* cdftok.c ends here */
@@ -0,0 +1,87 @@
+/*** cdftok.h -- tokeniser for LEI-CDF files
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if !defined INCLUDED_cdftok_h_
+#define INCLUDED_cdftok_h_
+
+#include <stddef.h>
+#include <libxml/parser.h>
+
+/**
+ * Return non-0 if the prolog of BUF (of length LEN) is something the
+ * tokeniser can deal with, i.e. UTF-8 and no DTD. */
+extern int cdftok_okp(const char *buf, size_t len);
+
+typedef struct cdftok_s *cdftok_t;
+
+/**
+ * Return a tokeniser that raises HDL's startElementNs, endElementNs
+ * and characters events with user data CTX.
+ * Names and namespace URIs passed to HDL are interned in DICT. */
+extern cdftok_t
+make_cdftok(const xmlSAXHandler *hdl, void *ctx, xmlDictPtr dict);
+
+/**
+ * Free resources associated with tokeniser T. */
+extern void free_cdftok(cdftok_t t);
+
+/**
+ * To be called from within T's startElementNs callback.
+ * Jump over the content of the element just opened without raising
+ * any events for it, its endElementNs is raised as usual.
+ * The element has to end in the same buffer it started in. */
+extern void cdftok_skip(cdftok_t t);
+
+/**
+ * Tokenise BUF of length LEN.
+ * BUF may be a piece of a document as long as it starts and ends
+ * outside of markup, consecutive calls continue where the last one
+ * left off.
+ * Return 0 on success or -1 if BUF is malformed. */
+extern int cdftok_parse(cdftok_t t, const char *buf, size_t len);
+
+/**
+ * To be called after the last piece of a document has been tokenised.
+ * Return 0 if the root element has been closed, i.e. the document is
+ * complete, or -1 if it ended before that. */
+extern int cdftok_fin(cdftok_t t);
+
+/**
+ * To be called from within T's startElementNs or endElementNs callback.
+ * Return a pointer just past the tag whose event is being raised. */
+extern const char *cdftok_at(cdftok_t t);
+
+#endif	/* INCLUDED_cdftok_h_ */
@@ -0,0 +1,147 @@
+/*** entdec.h -- XML character and entity references
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if !defined INCLUDED_entdec_h_
+#define INCLUDED_entdec_h_
+
+#include <stddef.h>
+#include <string.h>
+
+static inline size_t
+utf8_enc(char *restrict tgt, unsigned long c)
+{
+	if (c < 0x80U) {
+		tgt[0U] = (char)c;
+		return 1U;
+	} else if (c < 0x800U) {
+		tgt[0U] = (char)(0xc0U | (c >> 6U));
+		tgt[1U] = (char)(0x80U | (c & 0x3fU));
+		return 2U;
+	} else if (c < 0x10000U) {
+		tgt[0U] = (char)(0xe0U | (c >> 12U));
+		tgt[1U] = (char)(0x80U | ((c >> 6U) & 0x3fU));
+		tgt[2U] = (char)(0x80U | (c & 0x3fU));
+		return 3U;
+	}
+	tgt[0U] = (char)(0xf0U | (c >> 18U));
+	tgt[1U] = (char)(0x80U | ((c >> 12U) & 0x3fU));
+	tgt[2U] = (char)(0x80U | ((c >> 6U) & 0x3fU));
+	tgt[3U] = (char)(0x80U | (c & 0x3fU));
+	return 4U;
+}
+
+static inline size_t
+ent_dec(char *restrict tgt, const char *bp, const char *ep, const char **on)
+{
+/* decode the reference at BP (pointing to '&') into TGT which has room
+ * for at least 4 bytes, set ON to just past the reference and return
+ * the number of bytes written, or 0 if BP is no known reference */
+	const char *sp;
+	unsigned long c = 0U;
+
+	if ((sp = memchr(bp, ';', ep - bp < 12 ? ep - bp : 12)) == NULL) {
+		return 0U;
+	}
+	*on = sp + 1U;
+	bp++;
+
+	switch (sp - bp) {
+	case 2U:
+		if (!memcmp(bp, "lt", 2U)) {
+			*tgt = '<';
+			return 1U;
+		} else if (!memcmp(bp, "gt", 2U)) {
+			*tgt = '>';
+			return 1U;
+		}
+		break;
+	case 3U:
+		if (!memcmp(bp, "amp", 3U)) {
+			*tgt = '&';
+			return 1U;
+		}
+		break;
+	case 4U:
+		if (!memcmp(bp, "quot", 4U)) {
+			*tgt = '"';
+			return 1U;
+		} else if (!memcmp(bp, "apos", 4U)) {
+			*tgt = '\'';
+			return 1U;
+		}
+		break;
+	default:
+		break;
+	}
+	if (*bp++ != '#' || bp >= sp) {
+		return 0U;
+	} else if (*bp == 'x') {
+		if (++bp >= sp) {
+			return 0U;
+		}
+		for (; bp < sp; bp++) {
+			switch (*bp) {
+			case '0' ... '9':
+				c = (c << 4U) | (*bp - '0');
+				break;
+			case 'A' ... 'F':
+				c = (c << 4U) | (*bp - 'A' + 10);
+				break;
+			case 'a' ... 'f':
+				c = (c << 4U) | (*bp - 'a' + 10);
+				break;
+			default:
+				return 0U;
+			}
+		}
+	} else {
+		for (; bp < sp; bp++) {
+			switch (*bp) {
+			case '0' ... '9':
+				c = c * 10U + (*bp - '0');
+				break;
+			default:
+				return 0U;
+			}
+		}
+	}
+	if (!c || c > 0x10ffffU || (c >= 0xd800U && c < 0xe000U)) {
+		return 0U;
+	}
+	return utf8_enc(tgt, c);
+}
+
+#endif	/* INCLUDED_entdec_h_ */
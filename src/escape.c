@@ -0,0 +1,503 @@
+/*** escape.c -- escape kernels for turtle output
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <string.h>
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+# include <immintrin.h>
+# define HAVE_X86_SIMD
+#endif	/* __GNUC__ && x86 */
+#include "escape.h"
+
+#define strlenof(_x)	(sizeof(_x) - 1U)
+
+/* characters to escape */
+#define SET_STR	"\"\\\n"
+#define SET_LIT	"\"\\\n\r"
+#define SET_TSV	"\t\n\r\\"
+#define SET_CSV	",\"\n\r"
+/* json also escapes all control characters */
+#define SET_JSON	"\"\\"
+/* iris also escape space and all control characters */
+#define SET_IRI	"<>\"{}|^`\\"
+/* whitespace to normalise and characters to stop at */
+#define SET_WS	"\t\n\f"
+#define SET_NWS	"\"\\\r"
+
+
+/* scalar kernels, also used for the tails of the vector ones */
+static inline __attribute__((always_inline)) const char*
+scan_scalar(const char *bp, const char *ep, const char *set, size_t n)
+{
+	for (; bp < ep && memchr(set, *bp, n) == NULL; bp++);
+	return bp;
+}
+
+static inline __attribute__((always_inline)) const char*
+nws_scalar(char *op, const char *bp, const char *ep)
+{
+	for (; bp < ep; bp++) {
+		switch (*bp) {
+		case '\t':
+		case '\n':
+		case '\f':
+			*op++ = ' ';
+			break;
+		case '"':
+		case '\\':
+		case '\r':
+			return bp;
+		default:
+			*op++ = *bp;
+			break;
+		}
+	}
+	return ep;
+}
+
+static const char*
+scan_str_scalar(const char *bp, const char *ep)
+{
+	return scan_scalar(bp, ep, SET_STR, strlenof(SET_STR));
+}
+
+static const char*
+scan_lit_scalar(const char *bp, const char *ep)
+{
+	return scan_scalar(bp, ep, SET_LIT, strlenof(SET_LIT));
+}
+
+static const char*
+scan_iri_scalar(const char *bp, const char *ep)
+{
+	for (; bp < ep && (unsigned char)*bp > 0x20U &&
+		     memchr(SET_IRI, *bp, strlenof(SET_IRI)) == NULL; bp++);
+	return bp;
+}
+
+static const char*
+scan_tsv_scalar(const char *bp, const char *ep)
+{
+	return scan_scalar(bp, ep, SET_TSV, strlenof(SET_TSV));
+}
+
+static const char*
+scan_csv_scalar(const char *bp, const char *ep)
+{
+	return scan_scalar(bp, ep, SET_CSV, strlenof(SET_CSV));
+}
+
+static const char*
+scan_json_scalar(const char *bp, const char *ep)
+{
+	for (; bp < ep && (unsigned char)*bp >= 0x20U &&
+		     *bp != '"' && *bp != '\\'; bp++);
+	return bp;
+}
+
+static const char*
+copy_nws_scalar(char *op, const char *bp, const char *ep)
+{
+	return nws_scalar(op, bp, ep);
+}
+
+#if defined HAVE_X86_SIMD
+/* SSE2 */
+static inline __attribute__((always_inline, target("sse2"))) __m128i
+any_sse2(__m128i x, const char *set, size_t n)
+{
+	__m128i m = _mm_setzero_si128();
+
+	for (size_t i = 0U; i < n; i++) {
+		m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8(set[i])));
+	}
+	return m;
+}
+
+static inline __attribute__((always_inline, target("sse2"))) const char*
+scan_sse2(const char *bp, const char *ep, const char *set, size_t n)
+{
+	for (; bp + 16U <= ep; bp += 16U) {
+		const __m128i x = _mm_loadu_si128((const void*)bp);
+		const unsigned int b =
+			(unsigned int)_mm_movemask_epi8(any_sse2(x, set, n));
+
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return scan_scalar(bp, ep, set, n);
+}
+
+static __attribute__((target("sse2"))) const char*
+scan_str_sse2(const char *bp, const char *ep)
+{
+	return scan_sse2(bp, ep, SET_STR, strlenof(SET_STR));
+}
+
+static __attribute__((target("sse2"))) const char*
+scan_lit_sse2(const char *bp, const char *ep)
+{
+	return scan_sse2(bp, ep, SET_LIT, strlenof(SET_LIT));
+}
+
+static __attribute__((target("sse2"))) const char*
+scan_iri_sse2(const char *bp, const char *ep)
+{
+	const __m128i sp = _mm_set1_epi8(' ');
+
+	for (; bp + 16U <= ep; bp += 16U) {
+		const __m128i x = _mm_loadu_si128((const void*)bp);
+		const __m128i c = _mm_cmpeq_epi8(_mm_min_epu8(x, sp), x);
+		const unsigned int b = (unsigned int)_mm_movemask_epi8(
+			_mm_or_si128(c, any_sse2(x, SET_IRI, strlenof(SET_IRI))));
+
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return scan_iri_scalar(bp, ep);
+}
+
+static __attribute__((target("sse2"))) const char*
+scan_tsv_sse2(const char *bp, const char *ep)
+{
+	return scan_sse2(bp, ep, SET_TSV, strlenof(SET_TSV));
+}
+
+static __attribute__((target("sse2"))) const char*
+scan_csv_sse2(const char *bp, const char *ep)
+{
+	return scan_sse2(bp, ep, SET_CSV, strlenof(SET_CSV));
+}
+
+static __attribute__((target("sse2"))) const char*
+scan_json_sse2(const char *bp, const char *ep)
+{
+	const __m128i us = _mm_set1_epi8(0x1f);
+
+	for (; bp + 16U <= ep; bp += 16U) {
+		const __m128i x = _mm_loadu_si128((const void*)bp);
+		const __m128i c = _mm_cmpeq_epi8(_mm_min_epu8(x, us), x);
+		const unsigned int b = (unsigned int)_mm_movemask_epi8(
+			_mm_or_si128(c, any_sse2(x, SET_JSON, strlenof(SET_JSON))));
+
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return scan_json_scalar(bp, ep);
+}
+
+static __attribute__((target("sse2"))) const char*
+copy_nws_sse2(char *op, const char *bp, const char *ep)
+{
+	const __m128i sp = _mm_set1_epi8(' ');
+
+	for (; bp + 16U <= ep; bp += 16U, op += 16U) {
+		const __m128i x = _mm_loadu_si128((const void*)bp);
+		const __m128i ws = any_sse2(x, SET_WS, strlenof(SET_WS));
+		const __m128i st = any_sse2(x, SET_NWS, strlenof(SET_NWS));
+		const unsigned int b = (unsigned int)_mm_movemask_epi8(st);
+
+		_mm_storeu_si128(
+			(void*)op,
+			_mm_or_si128(
+				_mm_and_si128(ws, sp), _mm_andnot_si128(ws, x)));
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return nws_scalar(op, bp, ep);
+}
+
+/* AVX2 */
+static inline __attribute__((always_inline, target("avx2"))) __m256i
+any_avx2(__m256i x, const char *set, size_t n)
+{
+	__m256i m = _mm256_setzero_si256();
+
+	for (size_t i = 0U; i < n; i++) {
+		m = _mm256_or_si256(
+			m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(set[i])));
+	}
+	return m;
+}
+
+static inline __attribute__((always_inline, target("avx2"))) const char*
+scan_avx2(const char *bp, const char *ep, const char *set, size_t n)
+{
+	for (; bp + 32U <= ep; bp += 32U) {
+		const __m256i x = _mm256_loadu_si256((const void*)bp);
+		const unsigned int b =
+			(unsigned int)_mm256_movemask_epi8(any_avx2(x, set, n));
+
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return scan_scalar(bp, ep, set, n);
+}
+
+static __attribute__((target("avx2"))) const char*
+scan_str_avx2(const char *bp, const char *ep)
+{
+	return scan_avx2(bp, ep, SET_STR, strlenof(SET_STR));
+}
+
+static __attribute__((target("avx2"))) const char*
+scan_lit_avx2(const char *bp, const char *ep)
+{
+	return scan_avx2(bp, ep, SET_LIT, strlenof(SET_LIT));
+}
+
+static __attribute__((target("avx2"))) const char*
+scan_iri_avx2(const char *bp, const char *ep)
+{
+	const __m256i sp = _mm256_set1_epi8(' ');
+
+	for (; bp + 32U <= ep; bp += 32U) {
+		const __m256i x = _mm256_loadu_si256((const void*)bp);
+		const __m256i c = _mm256_cmpeq_epi8(_mm256_min_epu8(x, sp), x);
+		const unsigned int b = (unsigned int)_mm256_movemask_epi8(
+			_mm256_or_si256(
+				c, any_avx2(x, SET_IRI, strlenof(SET_IRI))));
+
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return scan_iri_scalar(bp, ep);
+}
+
+static __attribute__((target("avx2"))) const char*
+scan_tsv_avx2(const char *bp, const char *ep)
+{
+	return scan_avx2(bp, ep, SET_TSV, strlenof(SET_TSV));
+}
+
+static __attribute__((target("avx2"))) const char*
+scan_csv_avx2(const char *bp, const char *ep)
+{
+	return scan_avx2(bp, ep, SET_CSV, strlenof(SET_CSV));
+}
+
+static __attribute__((target("avx2"))) const char*
+scan_json_avx2(const char *bp, const char *ep)
+{
+	const __m256i us = _mm256_set1_epi8(0x1f);
+
+	for (; bp + 32U <= ep; bp += 32U) {
+		const __m256i x = _mm256_loadu_si256((const void*)bp);
+		const __m256i c = _mm256_cmpeq_epi8(_mm256_min_epu8(x, us), x);
+		const unsigned int b = (unsigned int)_mm256_movemask_epi8(
+			_mm256_or_si256(
+				c, any_avx2(x, SET_JSON, strlenof(SET_JSON))));
+
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return scan_json_scalar(bp, ep);
+}
+
+static __attribute__((target("avx2"))) const char*
+copy_nws_avx2(char *op, const char *bp, const char *ep)
+{
+	const __m256i sp = _mm256_set1_epi8(' ');
+
+	for (; bp + 32U <= ep; bp += 32U, op += 32U) {
+		const __m256i x = _mm256_loadu_si256((const void*)bp);
+		const __m256i ws = any_avx2(x, SET_WS, strlenof(SET_WS));
+		const __m256i st = any_avx2(x, SET_NWS, strlenof(SET_NWS));
+		const unsigned int b = (unsigned int)_mm256_movemask_epi8(st);
+
+		_mm256_storeu_si256((void*)op, _mm256_blendv_epi8(x, sp, ws));
+		if (b) {
+			return bp + __builtin_ctz(b);
+		}
+	}
+	return nws_scalar(op, bp, ep);
+}
+
+/* AVX-512 */
+static inline __attribute__((always_inline, target("avx512bw"))) __mmask64
+any_avx512(__m512i x, const char *set, size_t n)
+{
+	__mmask64 m = 0U;
+
+	for (size_t i = 0U; i < n; i++) {
+		m |= _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(set[i]));
+	}
+	return m;
+}
+
+static inline __attribute__((always_inline, target("avx512bw"))) const char*
+scan_avx512(const char *bp, const char *ep, const char *set, size_t n)
+{
+	for (; bp + 64U <= ep; bp += 64U) {
+		const __m512i x = _mm512_loadu_si512((const void*)bp);
+		const __mmask64 b = any_avx512(x, set, n);
+
+		if (b) {
+			return bp + __builtin_ctzll(b);
+		}
+	}
+	return scan_scalar(bp, ep, set, n);
+}
+
+static __attribute__((target("avx512bw"))) const char*
+scan_str_avx512(const char *bp, const char *ep)
+{
+	return scan_avx512(bp, ep, SET_STR, strlenof(SET_STR));
+}
+
+static __attribute__((target("avx512bw"))) const char*
+scan_lit_avx512(const char *bp, const char *ep)
+{
+	return scan_avx512(bp, ep, SET_LIT, strlenof(SET_LIT));
+}
+
+static __attribute__((target("avx512bw"))) const char*
+scan_iri_avx512(const char *bp, const char *ep)
+{
+	const __m512i sp = _mm512_set1_epi8(' ');
+
+	for (; bp + 64U <= ep; bp += 64U) {
+		const __m512i x = _mm512_loadu_si512((const void*)bp);
+		const __mmask64 b = _mm512_cmple_epu8_mask(x, sp) |
+			any_avx512(x, SET_IRI, strlenof(SET_IRI));
+
+		if (b) {
+			return bp + __builtin_ctzll(b);
+		}
+	}
+	return scan_iri_scalar(bp, ep);
+}
+
+static __attribute__((target("avx512bw"))) const char*
+scan_tsv_avx512(const char *bp, const char *ep)
+{
+	return scan_avx512(bp, ep, SET_TSV, strlenof(SET_TSV));
+}
+
+static __attribute__((target("avx512bw"))) const char*
+scan_csv_avx512(const char *bp, const char *ep)
+{
+	return scan_avx512(bp, ep, SET_CSV, strlenof(SET_CSV));
+}
+
+static __attribute__((target("avx512bw"))) const char*
+scan_json_avx512(const char *bp, const char *ep)
+{
+	const __m512i sp = _mm512_set1_epi8(' ');
+
+	for (; bp + 64U <= ep; bp += 64U) {
+		const __m512i x = _mm512_loadu_si512((const void*)bp);
+		const __mmask64 b = _mm512_cmplt_epu8_mask(x, sp) |
+			any_avx512(x, SET_JSON, strlenof(SET_JSON));
+
+		if (b) {
+			return bp + __builtin_ctzll(b);
+		}
+	}
+	return scan_json_scalar(bp, ep);
+}
+
+static __attribute__((target("avx512bw"))) const char*
+copy_nws_avx512(char *op, const char *bp, const char *ep)
+{
+	const __m512i sp = _mm512_set1_epi8(' ');
+
+	for (; bp + 64U <= ep; bp += 64U, op += 64U) {
+		const __m512i x = _mm512_loadu_si512((const void*)bp);
+		const __mmask64 ws = any_avx512(x, SET_WS, strlenof(SET_WS));
+		const __mmask64 st = any_avx512(x, SET_NWS, strlenof(SET_NWS));
+
+		_mm512_storeu_si512((void*)op, _mm512_mask_mov_epi8(x, ws, sp));
+		if (st) {
+			return bp + __builtin_ctzll(st);
+		}
+	}
+	return nws_scalar(op, bp, ep);
+}
+#endif	/* HAVE_X86_SIMD */
+
+const char *(*esc_scan_str)(const char*, const char*) = scan_str_scalar;
+const char *(*esc_scan_lit)(const char*, const char*) = scan_lit_scalar;
+const char *(*esc_scan_iri)(const char*, const char*) = scan_iri_scalar;
+const char *(*esc_scan_tsv)(const char*, const char*) = scan_tsv_scalar;
+const char *(*esc_scan_csv)(const char*, const char*) = scan_csv_scalar;
+const char *(*esc_scan_json)(const char*, const char*) = scan_json_scalar;
+const char *(*esc_copy_nws)(char*, const char*, const char*) = copy_nws_scalar;
+
+static void __attribute__((constructor))
+esc_init(void)
+{
+#if defined HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512bw")) {
+		esc_scan_str = scan_str_avx512;
+		esc_scan_lit = scan_lit_avx512;
+		esc_scan_iri = scan_iri_avx512;
+		esc_scan_tsv = scan_tsv_avx512;
+		esc_scan_csv = scan_csv_avx512;
+		esc_scan_json = scan_json_avx512;
+		esc_copy_nws = copy_nws_avx512;
+	} else if (__builtin_cpu_supports("avx2")) {
+		esc_scan_str = scan_str_avx2;
+		esc_scan_lit = scan_lit_avx2;
+		esc_scan_iri = scan_iri_avx2;
+		esc_scan_tsv = scan_tsv_avx2;
+		esc_scan_csv = scan_csv_avx2;
+		esc_scan_json = scan_json_avx2;
+		esc_copy_nws = copy_nws_avx2;
+	} else if (__builtin_cpu_supports("sse2")) {
+		esc_scan_str = scan_str_sse2;
+		esc_scan_lit = scan_lit_sse2;
+		esc_scan_iri = scan_iri_sse2;
+		esc_scan_tsv = scan_tsv_sse2;
+		esc_scan_csv = scan_csv_sse2;
+		esc_scan_json = scan_json_sse2;
+		esc_copy_nws = copy_nws_sse2;
+	}
+#endif	/* HAVE_X86_SIMD */
+	return;
+}
+
+/* escape.c ends here */
@@ -0,0 +1,79 @@
+/*** escape.h -- escape kernels for turtle output
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if !defined INCLUDED_escape_h_
+#define INCLUDED_escape_h_
+
+#include <stddef.h>
+
+/**
+ * Return a pointer to the first `"', `\' or newline in [BP, EP), i.e.
+ * the next character to escape in a turtle string, or EP if none. */
+extern const char *(*esc_scan_str)(const char *bp, const char *ep);
+
+/**
+ * Like esc_scan_str() but also stop at carriage returns, for string
+ * literals that have to stay on one line. */
+extern const char *(*esc_scan_lit)(const char *bp, const char *ep);
+
+/**
+ * Like esc_scan_str() but for the characters to escape in an IRI,
+ * space, all control characters and any of `<>"{}|^`\'. */
+extern const char *(*esc_scan_iri)(const char *bp, const char *ep);
+
+/**
+ * Like esc_scan_str() but for the characters to escape in a TSV field,
+ * tab, newline, carriage return and `\'. */
+extern const char *(*esc_scan_tsv)(const char *bp, const char *ep);
+
+/**
+ * Like esc_scan_str() but for the characters that make a CSV field
+ * need quoting, `,', `"', newline and carriage return. */
+extern const char *(*esc_scan_csv)(const char *bp, const char *ep);
+
+/**
+ * Like esc_scan_str() but for the characters to escape in a JSON
+ * string, `"', `\' and all control characters. */
+extern const char *(*esc_scan_json)(const char *bp, const char *ep);
+
+/**
+ * Copy [BP, EP) to OP up to the first `"', `\' or carriage return,
+ * turning tabs, newlines and form feeds into spaces on the way.
+ * Return a pointer to the character stopped at, or EP if none.
+ * OP must have room for EP - BP bytes, which may all be written. */
+extern const char *(*esc_copy_nws)(char *op, const char *bp, const char *ep);
+
+#endif	/* INCLUDED_escape_h_ */
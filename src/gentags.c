@@ -0,0 +1,235 @@
+/*** gentags.c -- generate element dispatch tables
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+/**
+ * Read rows `FLAVOUR NAME SLOT WHERE' (see leitags.def) from stdin and
+ * write a header with TAG_* constants for all names and, per flavour,
+ * a perfect hash table mapping names to their tag, slot and section. */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include "taghash.h"
+
+#define countof(_x)	(sizeof(_x) / sizeof(*_x))
+
+/* largest table we're prepared to generate, in bits */
+#define MAXBITS	(10U)
+
+struct row_s {
+	char fl[32U];
+	char name[64U];
+	char slot[32U];
+	char where[32U];
+	/* index into the list of distinct names */
+	size_t tag;
+};
+
+static struct row_s rows[256U];
+static size_t nrows;
+/* distinct names, as indices into rows */
+static size_t names[countof(rows)];
+static size_t nnames;
+/* distinct flavours, likewise */
+static size_t fls[countof(rows)];
+static size_t nfls;
+
+
+static int
+read_rows(FILE *fp)
+{
+	char line[256U];
+	size_t nl = 0U;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		struct row_s *r = rows + nrows;
+		int n;
+
+		nl++;
+		if (*line == '#' || *line == '\n') {
+			continue;
+		} else if (nrows >= countof(rows)) {
+			fputs("gentags: Error: too many rows\n", stderr);
+			return -1;
+		}
+		n = sscanf(line, "%31s %63s %31s %31s",
+			   r->fl, r->name, r->slot, r->where);
+		if (n != 4) {
+			fprintf(stderr, "\
+gentags: Error: line %zu: need FLAVOUR NAME SLOT WHERE\n", nl);
+			return -1;
+		}
+		/* register name */
+		for (r->tag = 0U; r->tag < nnames; r->tag++) {
+			if (!strcmp(rows[names[r->tag]].name, r->name)) {
+				break;
+			}
+		}
+		if (r->tag >= nnames) {
+			names[nnames++] = nrows;
+		}
+		/* register flavour */
+		if (strcmp(r->fl, "-")) {
+			size_t i;
+
+			for (i = 0U; i < nfls; i++) {
+				if (!strcmp(rows[fls[i]].fl, r->fl)) {
+					break;
+				}
+			}
+			if (i >= nfls) {
+				fls[nfls++] = nrows;
+			}
+		}
+		nrows++;
+	}
+	return 0;
+}
+
+static bool
+collidesp(const char *fl, uint32_t seed, unsigned int bits)
+{
+	const unsigned int shift = 32U - bits;
+	bool used[1U << MAXBITS] = {false};
+
+	for (size_t i = 0U; i < nrows; i++) {
+		uint32_t h;
+
+		if (strcmp(rows[i].fl, fl)) {
+			continue;
+		}
+		h = tag_hash((const unsigned char*)rows[i].name, seed) >> shift;
+		if (used[h]) {
+			return true;
+		}
+		used[h] = true;
+	}
+	return false;
+}
+
+static int
+write_table(FILE *fp, const char *fl)
+{
+	const struct row_s *slot[1U << MAXBITS];
+	unsigned int bits;
+	uint32_t seed = 0U;
+	size_t n = 0U;
+
+	for (size_t i = 0U; i < nrows; i++) {
+		n += !strcmp(rows[i].fl, fl);
+	}
+	/* start with a load factor below 1/2 */
+	for (bits = 1U; (1U << bits) < 2U * n; bits++);
+	for (; bits <= MAXBITS; bits++) {
+		for (seed = 0x811c9dc5U; seed < 0x811c9dc5U + 100000U; seed++) {
+			if (!collidesp(fl, seed, bits)) {
+				goto found;
+			}
+		}
+	}
+	fprintf(stderr, "gentags: Error: no perfect hash for `%s'\n", fl);
+	return -1;
+
+found:
+	memset(slot, 0, sizeof(slot));
+	for (size_t i = 0U; i < nrows; i++) {
+		uint32_t h;
+
+		if (strcmp(rows[i].fl, fl)) {
+			continue;
+		}
+		h = tag_hash((const unsigned char*)rows[i].name, seed);
+		slot[h >> (32U - bits)] = rows + i;
+	}
+
+	fprintf(fp, "static const struct tag_s %s_tag[%uU] = {\n", fl, 1U << bits);
+	for (size_t i = 0U; i < (1U << bits); i++) {
+		const struct row_s *r = slot[i];
+
+		if (r == NULL) {
+			fputs("\t{NTAGS, NFLDS, IN_REC},\n", fp);
+			continue;
+		}
+		fprintf(fp, "\t{TAG_%s, %s, %s},\n",
+			r->name, strcmp(r->slot, "-") ? r->slot : "NFLDS",
+			r->where);
+	}
+	fputs("};\n\n", fp);
+	fprintf(fp, "\
+static const struct tagtab_s %s_tt = {\n\
+\t.seed = 0x%08xU,\n\
+\t.shift = %uU,\n\
+\t.tag = %s_tag,\n\
+};\n\n", fl, seed, 32U - bits, fl);
+	return 0;
+}
+
+int
+main(void)
+{
+	FILE *fp = stdout;
+
+	if (read_rows(stdin) < 0) {
+		return 1;
+	}
+
+	fputs("/* generated by gentags, do not edit */\n\n", fp);
+	fputs("enum {\n", fp);
+	for (size_t i = 0U; i < nnames; i++) {
+		fprintf(fp, "\tTAG_%s,\n", rows[names[i]].name);
+	}
+	fputs("\tNTAGS\n};\n\n", fp);
+
+	fputs("static const char *const tagstr[NTAGS] = {\n", fp);
+	for (size_t i = 0U; i < nnames; i++) {
+		const char *name = rows[names[i]].name;
+		fprintf(fp, "\t[TAG_%s] = \"%s\",\n", name, name);
+	}
+	fputs("};\n\n", fp);
+
+	for (size_t i = 0U; i < nfls; i++) {
+		if (write_table(fp, rows[fls[i]].fl) < 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* gentags.c ends here */
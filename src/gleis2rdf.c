@@ -38,17 +38,35 @@
 # include "config.h"
 #endif	/* HAVE_CONFIG_H */
 #include <unistd.h>
+#include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #if defined __INTEL_COMPILER
 # pragma warning (disable:1292)
 #endif  /* __INTEL_COMPILER */
 #include <libxml/parser.h>
+#include <libxml/parserInternals.h>
 #if defined __INTEL_COMPILER
 # pragma warning (default:1292)
 #endif  /* __INTEL_COMPILER */
+#include "cdftok.h"
+#include "taghash.h"
+#include "unz.h"
+#include "entdec.h"
+#include "escape.h"
+#include "hdt.h"
+#include "arrow.h"
+#include "snap.h"
 
 #if !defined UNUSED
 # define UNUSED(_x)	__attribute__((unused)) _x##_unused
@@ -62,52 +80,51 @@
 #define countof(_x)	(sizeof(_x) / sizeof(*_x))
 #define strlenof(_x)	(sizeof(_x) - 1U)
 
-#if defined __GLIBC__ && __GLIBC__ >= 2
-# define fputc	fputc_unlocked
-# define fwrite	fwrite_unlocked
-#endif
+/* fields of a record, the slots of struct lei_s */
+enum {
+	FLD_LEI,
+	FLD_NAME,
+	FLD_FORM,
+	FLD_FCOD,
+	FLD_OFRM,
+	FLD_JRSD,
+	FLD_STAT,
+	FLD_DATE,
+	FLD_IRDATE,
+	FLD_LUDATE,
+	NFLDS,
+	/* not a field, the element's subtree is of no interest */
+	FLD_SKIP
+};
+
+struct fld_s {
+	off_t off;
+	size_t len;
+	/* if non-NULL the field's text lives in the input, not sbuf */
+	const char *ext;
+};
 
 struct lei_s {
-	off_t lei;
-	size_t llen;
-	off_t name;
-	size_t nlen;
-	off_t form;
-	size_t flen;
-	off_t fcod;
-	size_t clen;
-	off_t ofrm;
-	size_t olen;
-	off_t jrsd;
-	size_t jlen;
-	off_t stat;
-	size_t slen;
+	union {
+		struct fld_s fld[NFLDS];
+		struct {
+			struct fld_s lei;
+			struct fld_s name;
+			struct fld_s form;
+			struct fld_s fcod;
+			struct fld_s ofrm;
+			struct fld_s jrsd;
+			struct fld_s stat;
+			struct fld_s date;
+			struct fld_s irdate;
+			struct fld_s ludate;
+		};
+	};
 	char lang[8U];
-	off_t date;
-	size_t dlen;
-	off_t irdate;
-	size_t irdlen;
-	off_t ludate;
-	size_t ludlen;
 };
 
 
 /* aux stuff */
-static const char*
-tag_massage(const char *tag)
-{
-/* return the real part of a (ns'd) tag or attribute,
- * i.e. foo:that_tag becomes that_tag */
-	const char *p = strchr(tag, ':');
-
-	if (p) {
-		/* skip over ':' */
-		return p + 1;
-	}
-	/* otherwise just return the tag as is */
-	return tag;
-}
-
 static inline __attribute__((unused, pure, const)) char
 c2h(int x)
 {
@@ -118,11 +135,89 @@ c2h(int x)
 	return (char)(y + '7');
 }
 
+static size_t
+strtoz(const char *str)
+{
+/* read a size, with an optional k or M suffix */
+	char *on;
+	long int n = strtol(str, &on, 0);
+
+	switch (*on) {
+	case 'k':
+	case 'K':
+		n *= 1024L;
+		break;
+	case 'm':
+	case 'M':
+		n *= 1024L * 1024L;
+		break;
+	default:
+		break;
+	}
+	return n > 0 ? (size_t)n : 0U;
+}
+
+static const char*
+xmemmem(const char *hay, const size_t hz, const char *ndl, const size_t nz)
+{
+	const char *const eoh = hay + hz - nz + 1U;
+
+	if (UNLIKELY(nz == 0U || hz < nz)) {
+		return NULL;
+	}
+	for (const char *hp = hay;
+	     (hp = memchr(hp, *ndl, eoh - hp)) != NULL; hp++) {
+		if (!memcmp(hp, ndl, nz)) {
+			return hp;
+		}
+	}
+	return NULL;
+}
+
+static inline const char*
+skip_ws(const char *sp, const char *ep)
+{
+	for (; sp < ep && (*sp == ' ' || *sp == '\t' ||
+			   *sp == '\n' || *sp == '\f'); sp++);
+	return sp;
+}
+
+static char*
+nws_copy(char *op, const char *s, size_t z)
+{
+/* copy S to OP with whitespace normalised like in the rdf outputs,
+ * OP must have room for Z bytes, return the end of the copy */
+	const char *const ep = s + z;
+
+	for (const char *sp = skip_ws(s, ep), *tp;; sp = tp + 1U) {
+		tp = esc_copy_nws(op, sp, ep);
+		op += tp - sp;
+		if (tp >= ep) {
+			break;
+		}
+		*op++ = *tp;
+	}
+	return op;
+}
+
 
-/* temporary buffer */
-static char *sbuf;
-static size_t sbix;
-static size_t sbsz;
+/* temporary buffer, one per thread */
+static __thread char *sbuf;
+static __thread size_t sbix;
+static __thread size_t sbsz;
+/* end of the massaged part of sbuf */
+static __thread size_t sbmx;
+
+/* input that stays put for the duration of the parse, text within it
+ * is referenced rather than copied into sbuf */
+static __thread const char *inb;
+static __thread const char *ine;
+/* start of the current field in sbuf and its pending input span */
+static __thread size_t sbfo;
+static __thread const char *spb;
+static __thread size_t spz;
+/* number of open fields, text of nested ones is part of all of them */
+static __thread unsigned int nfo;
 
 static int
 sax_buf_resz(size_t len)
@@ -156,99 +251,373 @@ sax_buf_push(const char *txt, size_t len)
 static size_t
 sax_buf_massage(size_t from)
 {
-	size_t i;
-	size_t o;
-	const char *tp;
+/* decode references left in the text from FROM onwards, those are
+ * typically the result of double escaping; text that has been
+ * massaged before is left alone, so nested fields are decoded once */
+	const char *const ep = sbuf + sbix;
+	const char *ip, *tp;
+	char *op;
 
-	if (LIKELY((tp = strchr(sbuf + from, '&')) == NULL)) {
+	if (from < sbmx) {
+		from = sbmx;
+	}
+	if (LIKELY((tp = memchr(sbuf + from, '&', sbix - from)) == NULL)) {
 		/* nothing to do */
-		return sbix;
+		return sbmx = sbix;
 	}
-	/* otherwise head-start on the copy-and-decode loop */
-	for (i = o = tp - sbuf; i < sbix; i++, o++) {
-		if ((sbuf[o] = sbuf[i]) == '&') {
-			if (0) {
-				;
-			} else if (!memcmp(sbuf + i, "&amp;", 5U)) {
-				sbuf[o] = '&';
-				i += 4U;
-			} else if (!memcmp(sbuf + i, "&lt;", 4U)) {
-				sbuf[o] = '<';
-				i += 3U;
-			} else if (!memcmp(sbuf + i, "&gt;", 4U)) {
-				sbuf[o] = '>';
-				i += 3U;
-			} else if (!memcmp(sbuf + i, "&quot;", 6U)) {
-				sbuf[o] = '"';
-				i += 5U;
-			} else if (!memcmp(sbuf + i, "&apos;", 6U)) {
-				sbuf[o] = '\'';
-				i += 5U;
-			}
+	/* copy clean runs in bulk, decode what's in between */
+	for (ip = tp, op = sbuf + (tp - sbuf); tp != NULL;
+	     tp = memchr(ip, '&', ep - ip)) {
+		const char *on;
+		char c[4U];
+		size_t z;
+
+		memmove(op, ip, tp - ip);
+		op += tp - ip;
+		if ((z = ent_dec(c, tp, ep, &on))) {
+			memcpy(op, c, z);
+			op += z;
+			ip = on;
+		} else {
+			/* no reference, keep the & */
+			*op++ = *tp;
+			ip = tp + 1U;
 		}
 	}
-	sbuf[sbix = o] = '\0';
-	return sbix;
+	memmove(op, ip, ep - ip);
+	op += ep - ip;
+	sbuf[sbix = op - sbuf] = '\0';
+	return sbmx = sbix;
 }
 
 static void
 sax_buf_reset(void)
 {
 	sbix = 0U;
+	sbmx = 0U;
+	spz = 0U;
+	nfo = 0U;
+	return;
+}
+
+static void
+sax_buf_free(void)
+{
+	if (LIKELY(sbuf != NULL)) {
+		free(sbuf);
+		sbuf = NULL;
+		sbix = 0U;
+		sbsz = 0U;
+		sbmx = 0U;
+		spz = 0U;
+	}
+	return;
+}
+
+static void
+sax_span_flush(void)
+{
+/* copy the pending span into sbuf */
+	if (spz) {
+		sax_buf_push(spb, spz);
+		spz = 0U;
+	}
+	return;
+}
+
+static void
+sax_span_text(const char *txt, size_t len)
+{
+	if (txt >= inb && txt + len <= ine) {
+		if (!spz && sbix == sbfo) {
+			/* first piece of the field, keep a reference */
+			spb = txt;
+			spz = len;
+			return;
+		} else if (spz && spb + spz == txt) {
+			/* contiguous */
+			spz += len;
+			return;
+		}
+	}
+	sax_span_flush();
+	sax_buf_push(txt, len);
+	return;
+}
+
+static inline const char*
+fld_ptr(const struct fld_s *f)
+{
+	return f->ext ?: sbuf + f->off;
+}
+
+static void
+sax_fld_beg(struct fld_s *f)
+{
+	/* pending text belongs to an enclosing field */
+	sax_span_flush();
+	f->off = sbfo = sbix;
+	nfo++;
+	return;
+}
+
+static void
+sax_fld_end(struct fld_s *f, bool massp)
+{
+	nfo -= nfo > 0U;
+	if (!nfo && spz && sbix == (size_t)f->off &&
+	    !(massp && memchr(spb, '&', spz) != NULL)) {
+		/* all of the field is in the input and needs no decoding,
+		 * and no enclosing field needs it in sbuf */
+		f->ext = spb;
+		f->len = spz;
+		spz = 0U;
+		return;
+	}
+	sax_span_flush();
+	f->len = (massp ? sax_buf_massage(f->off) : sbix) - f->off;
 	return;
 }
 
+
+/* output stream, stdout or a worker's memory buffer */
+struct obuf_s {
+	char *buf;
+	size_t bix;
+	size_t bsz;
+	/* descriptor to write to whenever BSZ is reached,
+	 * or -1 for buffers that grow in memory */
+	int fd;
+};
+
+/* default size of descriptor buffers */
+#define OBUF_DEF	(4U * 1024U * 1024U)
+static size_t obufz = OBUF_DEF;
+/* the one buffer for stdout, shared by whichever thread prints */
+static struct obuf_s sout = {.fd = STDOUT_FILENO};
+static __thread struct obuf_s *out;
+/* flush output after every record */
+static bool unbufp;
+/* output format */
+static enum {
+	OFMT_TTL,
+	OFMT_NT,
+	OFMT_NQ,
+	OFMT_HDT,
+	OFMT_TSV,
+	OFMT_CSV,
+	OFMT_NDJSON,
+	OFMT_ARROW,
+	OFMT_SNAP,
+} ofmt;
+/* what names the graph of a record in n-quads */
+static enum {
+	GRAPH_LUDATE,
+	GRAPH_CONTENT,
+} graph;
+/* suppress the prefix preamble, for all but the first chunk */
+static __thread bool nopre;
+
 static int
-out_buf_push(const char *str, size_t len)
+obuf_wr(int fd, const struct iovec *v, int nv)
+{
+/* write all of the NV vectors V to FD */
+	struct iovec iov[2U];
+
+	memcpy(iov, v, nv * sizeof(*v));
+	for (struct iovec *vp = iov; nv > 0;) {
+		ssize_t nwr = writev(fd, vp, nv);
+
+		if (UNLIKELY(nwr < 0)) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		for (; nv > 0 && (size_t)nwr >= vp->iov_len; vp++, nv--) {
+			nwr -= vp->iov_len;
+		}
+		if (nv > 0) {
+			vp->iov_base = (char*)vp->iov_base + nwr;
+			vp->iov_len -= nwr;
+		}
+	}
+	return 0;
+}
+
+static int
+obuf_flush(struct obuf_s *o)
+{
+	int rc = 0;
+
+	if (o->fd >= 0 && o->bix) {
+		const struct iovec v = {o->buf, o->bix};
+
+		rc = obuf_wr(o->fd, &v, 1);
+		o->bix = 0U;
+	}
+	return rc;
+}
+
+static int
+obuf_room(struct obuf_s *o, size_t len)
+{
+/* make room for LEN more bytes in O */
+	size_t nu;
+	char *b;
+
+	if (LIKELY(o->bix + len <= o->bsz)) {
+		return 0;
+	} else if (o->fd >= 0 && UNLIKELY(obuf_flush(o) < 0)) {
+		return -1;
+	} else if (o->bix + len <= o->bsz) {
+		return 0;
+	}
+	nu = o->bsz ?: o->fd >= 0 ? obufz : 65536U;
+	for (; nu < o->bix + len; nu *= 2U);
+	if (UNLIKELY((b = realloc(o->buf, nu)) == NULL)) {
+		return -1;
+	}
+	o->buf = b;
+	o->bsz = nu;
+	return 0;
+}
+
+static int
+obuf_write(struct obuf_s *o, const char *str, size_t len)
 {
-	fwrite(str, sizeof(*str), len, stdout);
+/* append STR of length LEN to O, big pieces are written out directly
+ * along with what's buffered */
+	if (o->fd >= 0 && o->bsz && o->bix + len > o->bsz &&
+	    len >= o->bsz / 2U) {
+		const struct iovec v[] = {
+			{o->buf, o->bix}, {(void*)(uintptr_t)str, len}
+		};
+
+		o->bix = 0U;
+		return obuf_wr(o->fd, v, countof(v));
+	} else if (UNLIKELY(obuf_room(o, len) < 0)) {
+		return -1;
+	}
+	memcpy(o->buf + o->bix, str, len);
+	o->bix += len;
 	return 0;
 }
 
+static void
+obuf_free(struct obuf_s *o)
+{
+	obuf_flush(o);
+	free(o->buf);
+	o->buf = NULL;
+	o->bix = o->bsz = 0U;
+	return;
+}
+
+static inline char*
+out_room(size_t len)
+{
+/* return a pointer to at least LEN free bytes in OUT,
+ * bytes used are to be added to OUT->bix */
+	if (UNLIKELY(obuf_room(out, len) < 0)) {
+		return NULL;
+	}
+	return out->buf + out->bix;
+}
+
+static int
+out_buf_push(const char *str, size_t len)
+{
+	if (LIKELY(out->bix + len <= out->bsz)) {
+		memcpy(out->buf + out->bix, str, len);
+		out->bix += len;
+		return 0;
+	}
+	return obuf_write(out, str, len);
+}
+
 static int
 out_buf_push_esc(const char *str, size_t len)
 {
 /* like out_buf_push() but account for the necessity that we have
  * to escape every character */
-	/* now esc-copy */
-	for (size_t i = 0U; i < len; i++) {
-		switch (str[i]) {
-		case '"':
-		case '\n':
-		case '\\':
-			fputc('\\', stdout);
-		default:
-			fputc(str[i], stdout);
+	char *op, *const bp = out_room(2U * len);
+
+	if (UNLIKELY((op = bp) == NULL)) {
+		return -1;
+	}
+	/* now esc-copy, clean runs in bulk */
+	for (const char *sp = str, *const ep = str + len, *tp;; sp = tp + 1U) {
+		tp = esc_scan_str(sp, ep);
+		memcpy(op, sp, tp - sp);
+		op += tp - sp;
+		if (tp >= ep) {
 			break;
 		}
+		*op++ = '\\';
+		*op++ = *tp;
 	}
+	out->bix += op - bp;
 	return 0;
 }
 
 static int
-out_buf_push_iri(const char *str, size_t len)
+out_buf_push_lit(const char *str, size_t len)
 {
-/* like out_buf_push() but % escape things */
-	/* now esc-copy */
-	for (size_t i = 0U; i < len; i++) {
-		switch (str[i]) {
-		case '>':
-			fwrite("\\u003E", sizeof(char), 6U, stdout);
-			break;
-		case '<':
-			fwrite("\\u003C", sizeof(char), 6U, stdout);
-			break;
-		case '"':
-			fwrite("\\u0022", sizeof(char), 6U, stdout);
+/* like out_buf_push_esc() but keep the literal on one line */
+	char *op, *const bp = out_room(2U * len);
+
+	if (UNLIKELY((op = bp) == NULL)) {
+		return -1;
+	}
+	for (const char *sp = str, *const ep = str + len, *tp;; sp = tp + 1U) {
+		tp = esc_scan_lit(sp, ep);
+		memcpy(op, sp, tp - sp);
+		op += tp - sp;
+		if (tp >= ep) {
 			break;
+		}
+		*op++ = '\\';
+		switch (*tp) {
 		case '\n':
-			fwrite("\\u000A", sizeof(char), 6U, stdout);
+			*op++ = 'n';
+			break;
+		case '\r':
+			*op++ = 'r';
 			break;
 		default:
-			fputc(str[i], stdout);
+			*op++ = *tp;
+			break;
+		}
+	}
+	out->bix += op - bp;
+	return 0;
+}
+
+static int
+out_buf_push_iri(const char *str, size_t len)
+{
+/* like out_buf_push() but % escape things */
+	static const char hex[] = "0123456789ABCDEF";
+	char *op, *const bp = out_room(3U * len);
+
+	if (UNLIKELY((op = bp) == NULL)) {
+		return -1;
+	}
+	/* now esc-copy, clean runs in bulk */
+	for (const char *sp = str, *const ep = str + len, *tp;; sp = tp + 1U) {
+		tp = esc_scan_iri(sp, ep);
+		memcpy(op, sp, tp - sp);
+		op += tp - sp;
+		if (tp >= ep) {
 			break;
 		}
+		/* nothing an IRI may not contain gets through unescaped */
+		*op++ = '%';
+		*op++ = hex[(unsigned char)*tp >> 4U];
+		*op++ = hex[*tp & 0xfU];
 	}
+	out->bix += op - bp;
 	return 0;
 }
 
@@ -256,8 +625,12 @@ static int
 out_buf_push_esc_nws(const char *str, size_t len)
 {
 /* like out_buf_push_esc() but also normalise whitespace */
+	char *op, *const bp = out_room(2U * len);
 	size_t i = 0U;
 
+	if (UNLIKELY((op = bp) == NULL)) {
+		return -1;
+	}
 	/* skip leading ws */
 	for (i = 0U; i < len; i++) {
 		switch (str[i]) {
@@ -271,23 +644,19 @@ out_buf_push_esc_nws(const char *str, size_t len)
 		}
 		break;
 	}
-	/* now esc-copy */
-	for (; i < len; i++) {
-		switch (str[i]) {
-		case ' ':
-		case '\t':
-		case '\n':
-		case '\f':
-			fputc(' ', stdout);
-			break;
-		case '"':
-		case '\\':
-			fputc('\\', stdout);
-		default:
-			fputc(str[i], stdout);
+	/* now esc-copy, whitespace is normalised along the way */
+	for (const char *sp = str + i, *const ep = str + len, *tp;;
+	     sp = tp + 1U) {
+		tp = esc_copy_nws(op, sp, ep);
+		op += tp - sp;
+		if (tp >= ep) {
+			i = len;
 			break;
 		}
+		*op++ = '\\';
+		*op++ = *tp != '\r' ? *tp : 'r';
 	}
+	out->bix += op - bp;
 	/* kill trailing ws */
 	for (; i > 0; i--) {
 		switch (str[i - 1]) {
@@ -306,409 +675,2966 @@ out_buf_push_esc_nws(const char *str, size_t len)
 }
 
 
-/* our SAX parser */
-static bool pushp;
-static bool in_ent_p;
-static bool in_reg_p;
-static enum {
-	FL_UNK,
-	FL_CLEIS,
-	FL_PLEIS,
-} flavour;
+/* interned values
+ * fields like the jurisdiction or the status take only a few thousand
+ * distinct values, each one is given an id and the turtle it produces
+ * is rendered once and from then on copied verbatim */
+#define ITAB_N	(4096U)
 
-static xmlEntityPtr
-sax_get_ent(void *UNUSED(ctx), const xmlChar *name)
-{
-	return xmlGetPredefinedEntity(name);
-}
+enum {
+	IT_FCOD,
+	IT_FORM,
+	IT_JRSD,
+	IT_STAT,
+	IT_LANG,
+	NITABS
+};
 
-static void
-sax_text(void *UNUSED(ctx), const xmlChar *txt, int len)
+struct itab_s {
+	/* open addressing, slots hold ids + 1 */
+	uint16_t idx[2U * ITAB_N];
+	size_t nid;
+	struct {
+		uint32_t h;
+		/* value and turtle, as offsets into HEAP */
+		size_t voff, vlen;
+		size_t toff, tlen;
+	} id[ITAB_N];
+	char *heap;
+	size_t hix;
+	size_t hsz;
+};
+
+/* one set of tables per printing thread */
+static __thread struct itab_s *itab[NITABS];
+
+static inline uint32_t
+itab_hash(const char *s, size_t z)
 {
-	if (pushp) {
-		sax_buf_push((const char*)txt, (size_t)len);
+	uint32_t h = 0x811c9dc5U;
+
+	for (size_t i = 0U; i < z; i++) {
+		h ^= (unsigned char)s[i];
+		h *= 0x01000193U;
 	}
-	return;
+	return h;
 }
 
-static void
-sax_bo(void *ctx, const xmlChar *name, const xmlChar **atts)
+static ssize_t
+itab_heap(struct itab_s *t, const char *s, size_t z)
 {
-	/* where the real element name starts, sans ns prefix */
-	const char *rname = tag_massage((const char*)name);
-	struct lei_s *r = ctx;
+/* copy S of length Z onto T's heap, return its offset */
+	const size_t o = t->hix;
 
-	switch (flavour) {
-		static const char pre[] = "\
-@prefix lei: <http://openleis.com/legal_entities/> .\n\
-@prefix leiroc: <http://www.leiroc.org/data/schema/leidata/2014/> .\n\
-@prefix fibo-be-le-lei: <http://www.omg.org/spec/EDMC-FIBO/BE/LegalEntities/LEIEntities/> .\n\
-@prefix rov: <http://www.w3.org/ns/regorg#> .\n\
-@prefix gas: <http://schema.ga-group.nl/symbology#> .\n\
-@prefix xsd: <http://www.w3.org/2001/XMLSchema#> .\n\
-\n";
+	if (UNLIKELY(t->hix + z > t->hsz)) {
+		const size_t nu = ((t->hix + z) & ~0xfffU) + 4096U;
+		char *h;
 
-	case FL_UNK:
-		if (!strcmp(rname, "LEIRecords")) {
-			flavour = FL_CLEIS;
-		} else if (!strcmp(rname, "LEIRegistrations")) {
-			flavour = FL_PLEIS;
-		} else if (!strcmp((const char*)name, "lei:ContentDate")) {
-			r->date = sbix;
-			pushp = true;
-			break;
-		} else {
-			break;
+		if (UNLIKELY((h = realloc(t->heap, nu)) == NULL)) {
+			return -1;
 		}
-		out_buf_push(pre, strlenof(pre));
+		t->heap = h;
+		t->hsz = nu;
+	}
+	memcpy(t->heap + o, s, z);
+	t->hix += z;
+	return o;
+}
 
-		if (r->dlen) {
-			static const char tpre[] = "\
-@prefix TIME: <", post[] = "> .\n";
-			out_buf_push(tpre, strlenof(tpre));
-			out_buf_push(sbuf + r->date, r->dlen);
-			out_buf_push(post, strlenof(post));
-		}
-		break;
+static int
+itab_id(unsigned int which, const char *s, size_t z)
+{
+/* return the id of value S of length Z in table WHICH, interning it
+ * if need be, or -1 if the table is full */
+	struct itab_s *t = itab[which];
+	const uint32_t h = itab_hash(s, z);
+	size_t k;
+	ssize_t o;
 
-	case FL_CLEIS:
-		if (in_ent_p) {
-			if (0) {
-				;
-			} else if (!strcmp(rname, "LegalName")) {
-				r->name = sbix;
-				pushp = true;
-				if (atts) {
-					/* snarf language tag */
-					goto lang;
-				}
-			} else if (!strcmp(rname, "LegalForm")) {
-				r->form = sbix;
-				pushp = true;
-			} else if (!strcmp(rname, "EntityLegalFormCode")) {
-				r->fcod = sbix;
-				pushp = true;
-			} else if (!strcmp(rname, "OtherLegalForm")) {
-				r->ofrm = sbix;
-				pushp = true;
-			} else if (!strcmp(rname, "LegalJurisdiction")) {
-				r->jrsd = sbix;
-				pushp = true;
-			} else if (!strcmp(rname, "EntityStatus")) {
-				r->stat = sbix;
-				pushp = true;
-			}
-		} else if (in_reg_p) {
-			if (0) {
-				;
-			} else if (!strcmp(rname, "InitialRegistrationDate")) {
-				r->irdate = sbix;
-				pushp = true;
-			} else if (!strcmp(rname, "LastUpdateDate")) {
-				r->ludate = sbix;
-				pushp = true;
-			}
-		} else if (!strcmp(rname, "Entity")) {
-			in_ent_p = true;
-		} else if (!strcmp(rname, "Registration")) {
-			in_reg_p = true;
-		} else if (!strcmp(rname, "LEI")) {
-			r->lei = sbix;
-			pushp = true;
-		}
-		break;
-	lang:
-		for (const xmlChar **a = atts; *a; a++) {
-			const char *aname = tag_massage((const char*)*a++);
-			if (!strcmp(aname, "lang")) {
-				const char *lang = (const char*)*a;
-				const size_t llen = strlen(lang);
-				memcpy(r->lang, lang, llen < 7U ? llen : 7U);
-			}
-		}
-		break;
+	if (UNLIKELY(t == NULL) &&
+	    UNLIKELY((t = itab[which] = calloc(1U, sizeof(*t))) == NULL)) {
+		return -1;
+	}
+	for (k = h % countof(t->idx); t->idx[k];
+	     k = (k + 1U) % countof(t->idx)) {
+		const size_t i = t->idx[k] - 1U;
 
-	case FL_PLEIS:
-		if (!strcmp(rname, "LegalEntityIdentifier")) {
-			r->lei = sbix;
-			pushp = true;
-		} else if (!strcmp(rname, "RegisteredName")) {
-			r->name = sbix;
-			pushp = true;
-		} else if (!strcmp(rname, "EntityLegalForm")) {
-			r->form = sbix;
-			pushp = true;
-		} else if (!strcmp(rname, "RegisteredCountryCode")) {
-			r->jrsd = sbix;
-			pushp = true;
+		if (t->id[i].h == h && t->id[i].vlen == z &&
+		    !memcmp(t->heap + t->id[i].voff, s, z)) {
+			return (int)i;
 		}
-		break;
+	}
+	if (UNLIKELY(t->nid >= ITAB_N) ||
+	    UNLIKELY((o = itab_heap(t, s, z)) < 0)) {
+		return -1;
+	}
+	t->id[t->nid].h = h;
+	t->id[t->nid].voff = o;
+	t->id[t->nid].vlen = z;
+	t->id[t->nid].tlen = 0U;
+	t->idx[k] = (uint16_t)++t->nid;
+	return (int)(t->nid - 1U);
+}
 
-	default:
-		break;
+static void
+itab_free(void)
+{
+	for (size_t i = 0U; i < countof(itab); i++) {
+		if (itab[i] != NULL) {
+			free(itab[i]->heap);
+			free(itab[i]);
+			itab[i] = NULL;
+		}
 	}
 	return;
 }
 
+
+/* vocabulary */
+#define NS_LEI		"http://openleis.com/legal_entities/"
+#define NS_LEIROC	"http://www.leiroc.org/data/schema/leidata/2014/"
+#define NS_FIBO		\
+	"http://www.omg.org/spec/EDMC-FIBO/BE/LegalEntities/LEIEntities/"
+#define NS_ROV		"http://www.w3.org/ns/regorg#"
+#define NS_GAS		"http://schema.ga-group.nl/symbology#"
+#define NS_XSD		"http://www.w3.org/2001/XMLSchema#"
+#define NS_RDF		"http://www.w3.org/1999/02/22-rdf-syntax-ns#"
+#define NS_FORM		"http://openleis.com/legal_entities/search/legal_form/"
+#define NS_JRSD		"http://schema.ga-group.nl/jurisdictions#"
+/* graphs named after the last update or content date */
+#define NS_MODD		NS_LEI "updated/"
+#define NS_TIME		NS_LEI "content/"
+
+/* subject of the record being printed and the end of its statements,
+ * for formats that repeat them in every statement, cached statements
+ * start with a \0 in place of the subject and leave out the end */
+static __thread struct obuf_s sbj = {.fd = -1};
+static __thread struct obuf_s eos = {.fd = -1};
+static __thread bool fragp;
+/* graph named after the content date of the current file */
+static __thread struct obuf_s cgr = {.fd = -1};
+/* a record's values reassembled, for hdt and arrow */
+static __thread struct obuf_s rbuf = {.fd = -1};
+/* content date of the current file, for snapshots */
+static __thread struct obuf_s sdat = {.fd = -1};
+/* output on its way to the shards */
+static __thread struct obuf_s shb = {.fd = -1};
+
 static void
-sax_eo(void *ctx, const xmlChar *name)
+out_subj(void)
+{
+	if (fragp) {
+		out_buf_push("", 1U);
+		return;
+	}
+	out_buf_push(sbj.buf, sbj.bix);
+	return;
+}
+
+static void
+out_eos(void)
+{
+	if (fragp) {
+		return;
+	}
+	out_buf_push(eos.buf, eos.bix);
+	return;
+}
+
+static void
+out_free(void)
+{
+/* free the thread's output resources */
+	itab_free();
+	obuf_free(&sbj);
+	obuf_free(&eos);
+	obuf_free(&cgr);
+	obuf_free(&rbuf);
+	obuf_free(&sdat);
+	obuf_free(&shb);
+	return;
+}
+
+
+/* turtle */
+static void
+ttl_fcod(const char *s, size_t z)
+{
+	static const char tag[] = "leiroc:EntityLegalFormCode";
+
+	out_buf_push(";\n   ", 5U);
+	out_buf_push(tag, strlenof(tag));
+	out_buf_push(" \"", 2U);
+	out_buf_push_esc(s, z);
+	out_buf_push("\" ", 2U);
+	return;
+}
+
+static void
+ttl_form(const char *s, size_t z)
+{
+	/* append legal form */
+	static const char tag[] = "leiroc:LegalForm";
+	static const char typ[] = "rov:orgType";
+	static const char fpre[] = NS_FORM;
+
+	out_buf_push(";\n   ", 5U);
+	out_buf_push(tag, strlenof(tag));
+	out_buf_push(" \"\"\"", 4U);
+	out_buf_push_esc(s, z);
+	out_buf_push("\"\"\" ", 4U);
+
+	/* and as rov:orgType */
+	out_buf_push(";\n   ", 5U);
+	out_buf_push(typ, strlenof(typ));
+	out_buf_push(" <", 2U);
+	out_buf_push(fpre, strlenof(fpre));
+	out_buf_push_iri(s, z);
+	out_buf_push("> ", 2U);
+	return;
+}
+
+static void
+ttl_jrsd(const char *s, size_t z)
+{
+	static const char tag[] = "leiroc:LegalJurisdiction";
+	static const char jur[] = NS_JRSD;
+
+	out_buf_push(";\n   ", 5U);
+	out_buf_push(tag, strlenof(tag));
+	out_buf_push(" \"\"\"", 4U);
+	out_buf_push_esc(s, z);
+	out_buf_push("\"\"\" ", 4U);
+
+	/* and again as fibo-be-le-lei statement */
+	out_buf_push(";\n   ", 5U);
+	out_buf_push("fibo-be-le-lei:isRecognizedIn", 29U);
+	out_buf_push(" <", 2U);
+	out_buf_push(jur, strlenof(jur));
+	out_buf_push_iri(s, z);
+	out_buf_push("> ", 2U);
+	return;
+}
+
+static void
+ttl_stat(const char *s, size_t z)
+{
+	static const char tag[] = "rov:orgStatus";
+
+	out_buf_push(";\n   ", 5U);
+	out_buf_push(tag, strlenof(tag));
+	out_buf_push(" \"", 2U);
+	out_buf_push(s, z);
+	out_buf_push("\" ", 2U);
+	return;
+}
+
+static void
+ttl_lang(const char *s, size_t z)
+{
+	out_buf_push("\"\"\"@", 4U);
+	out_buf_push(s, z);
+	return;
+}
+
+static void
+out_ttl(unsigned int which, const char *s, size_t z,
+	void(*ttl)(const char*, size_t))
+{
+/* output the turtle TTL renders for value S of length Z, once rendered
+ * the result is kept in table WHICH for the next record to reuse */
+	const int i = itab_id(which, s, z);
+	struct itab_s *t = itab[which];
+	struct obuf_s *o = out, tmp = {.fd = -1};
+	ssize_t x;
+
+	if (UNLIKELY(i < 0)) {
+		/* table's full, render into the output directly */
+		ttl(s, z);
+		return;
+	} else if (LIKELY(t->id[i].tlen)) {
+		goto cpy;
+	}
+	/* first sighting, render into a buffer of its own */
+	out = &tmp;
+	fragp = true;
+	ttl(s, z);
+	fragp = false;
+	out = o;
+	if (UNLIKELY((x = itab_heap(t, tmp.buf, tmp.bix)) < 0)) {
+		out_buf_push(tmp.buf, tmp.bix);
+		free(tmp.buf);
+		return;
+	}
+	free(tmp.buf);
+	t->id[i].toff = x;
+	t->id[i].tlen = tmp.bix;
+cpy:
+	if (ofmt == OFMT_TTL) {
+		out_buf_push(t->heap + t->id[i].toff, t->id[i].tlen);
+		return;
+	}
+	/* put subject and end back in, statements start with a \0 */
+	for (const char *fp = t->heap + t->id[i].toff + 1U,
+		     *const fe = fp + t->id[i].tlen - 1U, *mp;; fp = mp + 1U) {
+		if ((mp = memchr(fp, '\0', fe - fp)) == NULL) {
+			mp = fe;
+		}
+		out_buf_push(sbj.buf, sbj.bix);
+		out_buf_push(fp, mp - fp);
+		out_buf_push(eos.buf, eos.bix);
+		if (mp >= fe) {
+			break;
+		}
+	}
+	return;
+}
+
+static void
+ttl_pre(const struct lei_s *r)
+{
+/* the preamble, R holds the header fields */
+	static const char pre[] =
+		"@prefix lei: <" NS_LEI "> .\n"
+		"@prefix leiroc: <" NS_LEIROC "> .\n"
+		"@prefix fibo-be-le-lei: <" NS_FIBO "> .\n"
+		"@prefix rov: <" NS_ROV "> .\n"
+		"@prefix gas: <" NS_GAS "> .\n"
+		"@prefix xsd: <" NS_XSD "> .\n"
+		"\n";
+
+	out_buf_push(pre, strlenof(pre));
+
+	if (r->date.len) {
+		static const char tpre[] = "\
+@prefix TIME: <", post[] = "> .\n";
+		out_buf_push(tpre, strlenof(tpre));
+		out_buf_push(fld_ptr(&r->date), r->date.len);
+		out_buf_push(post, strlenof(post));
+	}
+	return;
+}
+
+static void
+ttl_rec(const struct lei_s *r)
+{
+	/* provenance service */
+	if (r->ludate.len) {
+		static const char pre[] = "\
+@prefix MODD: <", post[] = "> .\n";
+
+		out_buf_push(pre, strlenof(pre));
+		out_buf_push(fld_ptr(&r->ludate), r->ludate.len);
+		out_buf_push(post, strlenof(post));
+	}
+	/* principal type info */
+	out_buf_push("lei:", 4U);
+	out_buf_push(fld_ptr(&r->lei), r->lei.len);
+	out_buf_push(" a leiroc:LEI ", 14U);
+
+	static const char lei[] =
+		", fibo-be-le-lei:LegalEntityIdentifier ";
+	static const char cce[] =
+		", fibo-be-le-lei:ContractuallyCapableEntity ";
+	out_buf_push(lei, strlenof(lei));
+	out_buf_push(cce, strlenof(cce));
+
+	static const char sof[] =
+		";\n   gas:symbolOf <http://openleis.com/> ";
+
+	out_buf_push(sof, strlenof(sof));
+
+	if (r->name.len) {
+		static const char tag[] = "leiroc:LegalName";
+		
+		out_buf_push(";\n   ", 5U);
+		out_buf_push(tag, strlenof(tag));
+		out_buf_push(" \"\"\"", 4U);
+		out_buf_push_esc_nws(fld_ptr(&r->name), r->name.len);
+		if (!*r->lang) {
+			out_buf_push("\"\"\" ", 4U);
+		} else {
+			out_ttl(IT_LANG, r->lang, strlen(r->lang), ttl_lang);
+		}
+	}
+	if (r->irdate.len) {
+		static const char tag[] = "leiroc:InitialRegistrationDate";
+		out_buf_push(";\n   ", 5U);
+		out_buf_push(tag, strlenof(tag));
+		out_buf_push(" \"", 2U);
+		out_buf_push(fld_ptr(&r->irdate), r->irdate.len);
+		out_buf_push("\"^^xsd:dateTime ", 16U);
+	}
+	if (r->ludate.len) {
+		static const char tag[] = "leiroc:LastUpdateDate";
+		out_buf_push(";\n   ", 5U);
+		out_buf_push(tag, strlenof(tag));
+		out_buf_push(" \"", 2U);
+		out_buf_push(fld_ptr(&r->ludate), r->ludate.len);
+		out_buf_push("\"^^xsd:dateTime ", 16U);
+	}
+	if (r->fcod.len && *fld_ptr(&r->fcod) != '<') {
+		out_ttl(IT_FCOD, fld_ptr(&r->fcod), r->fcod.len, ttl_fcod);
+	}
+	if (r->ofrm.len && *fld_ptr(&r->ofrm) != '<') {
+		out_ttl(IT_FORM, fld_ptr(&r->ofrm), r->ofrm.len, ttl_form);
+	}
+	if (r->form.len && !(r->ofrm.len || r->fcod.len) &&
+	    *fld_ptr(&r->form) != '<') {
+		out_ttl(IT_FORM, fld_ptr(&r->form), r->form.len, ttl_form);
+	}
+	if (r->jrsd.len) {
+		out_ttl(IT_JRSD, fld_ptr(&r->jrsd), r->jrsd.len, ttl_jrsd);
+	}
+	if (r->stat.len) {
+		out_ttl(IT_STAT, fld_ptr(&r->stat), r->stat.len, ttl_stat);
+	}
+
+	out_buf_push(".\n", 2U);
+	return;
+}
+
+
+/* n-triples, the turtle statements spelt out one per line */
+#define NT_P(_ns, _x)	" <" _ns _x "> "
+
+static void
+nt_fcod(const char *s, size_t z)
+{
+	static const char tag[] = NT_P(NS_LEIROC, "EntityLegalFormCode") "\"";
+
+	out_subj();
+	out_buf_push(tag, strlenof(tag));
+	out_buf_push_lit(s, z);
+	out_buf_push("\"", 1U);
+	out_eos();
+	return;
+}
+
+static void
+nt_form(const char *s, size_t z)
+{
+	static const char tag[] = NT_P(NS_LEIROC, "LegalForm") "\"";
+	static const char typ[] = NT_P(NS_ROV, "orgType") "<" NS_FORM;
+
+	out_subj();
+	out_buf_push(tag, strlenof(tag));
+	out_buf_push_lit(s, z);
+	out_buf_push("\"", 1U);
+	out_eos();
+
+	out_subj();
+	out_buf_push(typ, strlenof(typ));
+	out_buf_push_iri(s, z);
+	out_buf_push(">", 1U);
+	out_eos();
+	return;
+}
+
+static void
+nt_jrsd(const char *s, size_t z)
+{
+	static const char tag[] = NT_P(NS_LEIROC, "LegalJurisdiction") "\"";
+	static const char rec[] = NT_P(NS_FIBO, "isRecognizedIn") "<" NS_JRSD;
+
+	out_subj();
+	out_buf_push(tag, strlenof(tag));
+	out_buf_push_lit(s, z);
+	out_buf_push("\"", 1U);
+	out_eos();
+
+	out_subj();
+	out_buf_push(rec, strlenof(rec));
+	out_buf_push_iri(s, z);
+	out_buf_push(">", 1U);
+	out_eos();
+	return;
+}
+
+static void
+nt_stat(const char *s, size_t z)
+{
+	static const char tag[] = NT_P(NS_ROV, "orgStatus") "\"";
+
+	out_subj();
+	out_buf_push(tag, strlenof(tag));
+	out_buf_push_lit(s, z);
+	out_buf_push("\"", 1U);
+	out_eos();
+	return;
+}
+
+static void
+nt_date(const char *tag, size_t tz, const struct fld_s *f)
+{
+	static const char typ[] = "\"^^<" NS_XSD "dateTime>";
+
+	out_subj();
+	out_buf_push(tag, tz);
+	out_buf_push_lit(fld_ptr(f), f->len);
+	out_buf_push(typ, strlenof(typ));
+	out_eos();
+	return;
+}
+
+static void
+nt_pre(const struct lei_s *r)
+{
+/* no prefixes, just note the content date for naming graphs */
+	static const char pre[] = "<" NS_TIME;
+	struct obuf_s *o = out;
+
+	cgr.bix = 0U;
+	if (ofmt != OFMT_NQ || !r->date.len) {
+		return;
+	}
+	out = &cgr;
+	out_buf_push(pre, strlenof(pre));
+	out_buf_push_iri(fld_ptr(&r->date), r->date.len);
+	out_buf_push(">", 1U);
+	out = o;
+	return;
+}
+
+static void
+nt_subj(const struct lei_s *r)
+{
+/* render R's subject and statement end once for all of its statements */
+	static const char pre[] = "<" NS_LEI;
+	static const char modd[] = " <" NS_MODD;
+	struct obuf_s *o = out;
+
+	out = &sbj;
+	sbj.bix = 0U;
+	out_buf_push(pre, strlenof(pre));
+	out_buf_push_iri(fld_ptr(&r->lei), r->lei.len);
+	out_buf_push(">", 1U);
+
+	out = &eos;
+	eos.bix = 0U;
+	if (ofmt != OFMT_NQ) {
+		;
+	} else if (graph == GRAPH_LUDATE && r->ludate.len) {
+		out_buf_push(modd, strlenof(modd));
+		out_buf_push_iri(fld_ptr(&r->ludate), r->ludate.len);
+		out_buf_push(">", 1U);
+	} else if (cgr.bix) {
+		/* no update date, use the file's content date */
+		out_buf_push(" ", 1U);
+		out_buf_push(cgr.buf, cgr.bix);
+	}
+	out_buf_push(" .\n", 3U);
+	out = o;
+	return;
+}
+
+static void
+nt_rec(const struct lei_s *r)
+{
+	static const char typ[] =
+		NT_P(NS_RDF, "type") "<" NS_LEIROC "LEI>";
+	static const char lei[] =
+		NT_P(NS_RDF, "type") "<" NS_FIBO "LegalEntityIdentifier>";
+	static const char cce[] =
+		NT_P(NS_RDF, "type") "<" NS_FIBO "ContractuallyCapableEntity>";
+	static const char sof[] =
+		NT_P(NS_GAS, "symbolOf") "<http://openleis.com/>";
+
+	nt_subj(r);
+	out_subj();
+	out_buf_push(typ, strlenof(typ));
+	out_eos();
+	out_subj();
+	out_buf_push(lei, strlenof(lei));
+	out_eos();
+	out_subj();
+	out_buf_push(cce, strlenof(cce));
+	out_eos();
+	out_subj();
+	out_buf_push(sof, strlenof(sof));
+	out_eos();
+
+	if (r->name.len) {
+		static const char tag[] = NT_P(NS_LEIROC, "LegalName") "\"";
+
+		out_subj();
+		out_buf_push(tag, strlenof(tag));
+		out_buf_push_esc_nws(fld_ptr(&r->name), r->name.len);
+		out_buf_push("\"", 1U);
+		if (*r->lang) {
+			out_buf_push("@", 1U);
+			out_buf_push(r->lang, strlen(r->lang));
+		}
+		out_eos();
+	}
+	if (r->irdate.len) {
+		static const char tag[] =
+			NT_P(NS_LEIROC, "InitialRegistrationDate") "\"";
+		nt_date(tag, strlenof(tag), &r->irdate);
+	}
+	if (r->ludate.len) {
+		static const char tag[] =
+			NT_P(NS_LEIROC, "LastUpdateDate") "\"";
+		nt_date(tag, strlenof(tag), &r->ludate);
+	}
+	if (r->fcod.len && *fld_ptr(&r->fcod) != '<') {
+		out_ttl(IT_FCOD, fld_ptr(&r->fcod), r->fcod.len, nt_fcod);
+	}
+	if (r->ofrm.len && *fld_ptr(&r->ofrm) != '<') {
+		out_ttl(IT_FORM, fld_ptr(&r->ofrm), r->ofrm.len, nt_form);
+	}
+	if (r->form.len && !(r->ofrm.len || r->fcod.len) &&
+	    *fld_ptr(&r->form) != '<') {
+		out_ttl(IT_FORM, fld_ptr(&r->form), r->form.len, nt_form);
+	}
+	if (r->jrsd.len) {
+		out_ttl(IT_JRSD, fld_ptr(&r->jrsd), r->jrsd.len, nt_jrsd);
+	}
+	if (r->stat.len) {
+		out_ttl(IT_STAT, fld_ptr(&r->stat), r->stat.len, nt_stat);
+	}
+	return;
+}
+
+
+/* hdt, statements are collected from all threads and written at exit */
+static hdt_t hdt;
+static pthread_mutex_t hdt_mtx = PTHREAD_MUTEX_INITIALIZER;
+/* set when statements couldn't be collected */
+static bool hdt_lost;
+
+struct hstm_s {
+	const char *p;
+	size_t pz;
+	/* the object, in rbuf */
+	size_t off;
+	size_t len;
+};
+
+static size_t
+hdt_obj(const char *pre, size_t prez, const struct fld_s *f,
+	const char *post, size_t postz)
+{
+/* assemble the term PRE F POST in rbuf, return its offset,
+ * F is escaped like in n-triples if the term is an IRI (no POST) */
+	const size_t o = rbuf.bix;
+
+	obuf_write(&rbuf, pre, prez);
+	if (f == NULL) {
+		;
+	} else if (post == NULL) {
+		struct obuf_s *b = out;
+
+		out = &rbuf;
+		out_buf_push_iri(fld_ptr(f), f->len);
+		out = b;
+	} else {
+		obuf_write(&rbuf, fld_ptr(f), f->len);
+	}
+	obuf_write(&rbuf, post, postz);
+	return o;
+}
+
+static size_t
+hdt_name(const struct lei_s *r)
+{
+/* the name as literal, with whitespace normalised like in turtle */
+	const size_t o = rbuf.bix;
+	char *op;
+
+	if (UNLIKELY(obuf_room(&rbuf, r->name.len + 2U) < 0)) {
+		return o;
+	}
+	op = rbuf.buf + rbuf.bix;
+	*op++ = '"';
+	op = nws_copy(op, fld_ptr(&r->name), r->name.len);
+	*op++ = '"';
+	rbuf.bix = op - rbuf.buf;
+	if (*r->lang) {
+		obuf_write(&rbuf, "@", 1U);
+		obuf_write(&rbuf, r->lang, strlen(r->lang));
+	}
+	return o;
+}
+
+static void
+hdt_rec(const struct lei_s *r)
+{
+#define ST(_p, _o)	(struct hstm_s){.p = _p, .pz = strlenof(_p), .off = _o}
+#define IRI(_x, _f)	hdt_obj(_x, strlenof(_x), _f, NULL, 0U)
+#define LIT(_f, _x)	hdt_obj("\"", 1U, _f, _x, strlenof(_x))
+	static const char dtm[] = "\"^^<" NS_XSD "dateTime>";
+	struct hstm_s st[16U];
+	size_t nst = 0U;
+	size_t sz;
+
+	rbuf.bix = 0U;
+	IRI(NS_LEI, &r->lei);
+	sz = rbuf.bix;
+
+	st[nst++] = ST(NS_RDF "type", IRI(NS_LEIROC "LEI", NULL));
+	st[nst++] = ST(NS_RDF "type", IRI(NS_FIBO "LegalEntityIdentifier", NULL));
+	st[nst++] = ST(NS_RDF "type",
+		       IRI(NS_FIBO "ContractuallyCapableEntity", NULL));
+	st[nst++] = ST(NS_GAS "symbolOf", IRI("http://openleis.com/", NULL));
+
+	if (r->name.len) {
+		st[nst++] = ST(NS_LEIROC "LegalName", hdt_name(r));
+	}
+	if (r->irdate.len) {
+		st[nst++] = ST(NS_LEIROC "InitialRegistrationDate",
+			       LIT(&r->irdate, dtm));
+	}
+	if (r->ludate.len) {
+		st[nst++] = ST(NS_LEIROC "LastUpdateDate", LIT(&r->ludate, dtm));
+	}
+	if (r->fcod.len && *fld_ptr(&r->fcod) != '<') {
+		st[nst++] = ST(NS_LEIROC "EntityLegalFormCode",
+			       LIT(&r->fcod, "\""));
+	}
+	for (size_t i = 0U; i < 2U; i++) {
+		/* other legal form, or the legal form if nothing else is known */
+		const struct fld_s *f = !i ? &r->ofrm : &r->form;
+
+		if (!f->len || *fld_ptr(f) == '<' ||
+		    (i && (r->ofrm.len || r->fcod.len))) {
+			continue;
+		}
+		st[nst++] = ST(NS_LEIROC "LegalForm", LIT(f, "\""));
+		st[nst++] = ST(NS_ROV "orgType", IRI(NS_FORM, f));
+	}
+	if (r->jrsd.len) {
+		st[nst++] = ST(NS_LEIROC "LegalJurisdiction", LIT(&r->jrsd, "\""));
+		st[nst++] = ST(NS_FIBO "isRecognizedIn", IRI(NS_JRSD, &r->jrsd));
+	}
+	if (r->stat.len) {
+		st[nst++] = ST(NS_ROV "orgStatus", LIT(&r->stat, "\""));
+	}
+#undef ST
+#undef IRI
+#undef LIT
+
+	/* objects end where the next one starts */
+	for (size_t i = 0U; i < nst; i++) {
+		st[i].len = (i + 1U < nst ? st[i + 1U].off : rbuf.bix) - st[i].off;
+	}
+	pthread_mutex_lock(&hdt_mtx);
+	for (size_t i = 0U; i < nst; i++) {
+		if (UNLIKELY(hdt_add(hdt, rbuf.buf, sz, st[i].p, st[i].pz,
+				     rbuf.buf + st[i].off, st[i].len) < 0)) {
+			hdt_lost = true;
+		}
+	}
+	pthread_mutex_unlock(&hdt_mtx);
+	return;
+}
+
+
+/* delimited output, one row per record, columns as in DLM_HDR */
+#define DLM_HDR(_d)							\
+	"lei" _d "name" _d "lang" _d "legal_form" _d "form_code" _d	\
+	"other_form" _d "jurisdiction" _d "status" _d			\
+	"initial_registration" _d "last_update" "\n"
+#define DLM_NCOL	(10U)
+
+static bool
+row_fldp(const struct lei_s *r, const struct fld_s *f)
+{
+/* whether F goes into a row, forms are chosen like in the rdf outputs */
+	if (!f->len) {
+		return false;
+	} else if (f != &r->form && f != &r->fcod && f != &r->ofrm) {
+		return true;
+	} else if (*fld_ptr(f) == '<') {
+		/* structured legal form */
+		return false;
+	} else if (f == &r->form && (r->fcod.len || r->ofrm.len)) {
+		/* just the text around the code or other form */
+		return false;
+	}
+	return true;
+}
+
+static char*
+tsv_fld(char *op, const char *s, size_t z)
+{
+/* copy S to OP, escaping tabs, line breaks and backslashes */
+	for (const char *sp = s, *const ep = s + z, *tp;; sp = tp + 1U) {
+		tp = esc_scan_tsv(sp, ep);
+		memcpy(op, sp, tp - sp);
+		op += tp - sp;
+		if (tp >= ep) {
+			break;
+		}
+		*op++ = '\\';
+		switch (*tp) {
+		case '\t':
+			*op++ = 't';
+			break;
+		case '\n':
+			*op++ = 'n';
+			break;
+		case '\r':
+			*op++ = 'r';
+			break;
+		default:
+			*op++ = *tp;
+			break;
+		}
+	}
+	return op;
+}
+
+static char*
+tsv_name(char *op, const char *s, size_t z)
+{
+/* like tsv_fld() but normalise whitespace like the rdf outputs do */
+	const char *const ep = s + z;
+
+	for (const char *sp = skip_ws(s, ep), *tp;; sp = tp + 1U) {
+		tp = esc_copy_nws(op, sp, ep);
+		op += tp - sp;
+		if (tp >= ep) {
+			break;
+		}
+		switch (*tp) {
+		case '\\':
+			*op++ = '\\';
+			*op++ = '\\';
+			break;
+		case '\r':
+			*op++ = '\\';
+			*op++ = 'r';
+			break;
+		default:
+			*op++ = *tp;
+			break;
+		}
+	}
+	return op;
+}
+
+static char*
+csv_fld(char *op, const char *s, size_t z)
+{
+/* copy S to OP, quoted only if it has to be */
+	const char *sp = s, *const ep = s + z, *tp;
+
+	if (LIKELY((tp = esc_scan_csv(sp, ep)) >= ep)) {
+		memcpy(op, s, z);
+		return op + z;
+	}
+	*op++ = '"';
+	for (;; sp = tp + 1U) {
+		tp = memchr(sp, '"', ep - sp) ?: ep;
+		memcpy(op, sp, tp - sp);
+		op += tp - sp;
+		if (tp >= ep) {
+			break;
+		}
+		*op++ = '"';
+		*op++ = '"';
+	}
+	*op++ = '"';
+	return op;
+}
+
+static char*
+csv_name(char *op, const char *s, size_t z)
+{
+/* like csv_fld() but normalise whitespace like the rdf outputs do */
+	const char *sp = skip_ws(s, s + z), *const ep = s + z, *tp;
+	const bool qp = esc_scan_csv(sp, ep) < ep;
+
+	if (UNLIKELY(qp)) {
+		*op++ = '"';
+	}
+	for (;; sp = tp + 1U) {
+		tp = esc_copy_nws(op, sp, ep);
+		op += tp - sp;
+		if (tp >= ep) {
+			break;
+		}
+		if (*tp == '"') {
+			*op++ = '"';
+		}
+		*op++ = *tp;
+	}
+	if (UNLIKELY(qp)) {
+		*op++ = '"';
+	}
+	return op;
+}
+
+static void
+dlm_hdr(void)
+{
+	static const char tsv[] = DLM_HDR("\t");
+	static const char csv[] = DLM_HDR(",");
+
+	if (ofmt == OFMT_TSV) {
+		out_buf_push(tsv, strlenof(tsv));
+	} else {
+		out_buf_push(csv, strlenof(csv));
+	}
+	return;
+}
+
+static void
+dlm_rec(const struct lei_s *r)
+{
+	/* the columns in order, NULL for the language */
+	const struct fld_s *col[DLM_NCOL] = {
+		&r->lei, &r->name, NULL, &r->form, &r->fcod, &r->ofrm,
+		&r->jrsd, &r->stat, &r->irdate, &r->ludate,
+	};
+	const size_t lz = strlen(r->lang);
+	const bool csvp = ofmt == OFMT_CSV;
+	const char sep = (char)(csvp ? ',' : '\t');
+	char *op, *bp;
+	size_t z = 2U * lz + 2U + DLM_NCOL;
+
+	/* room for the whole row, worst case every byte escaped */
+	for (size_t i = 0U; i < DLM_NCOL; i++) {
+		z += col[i] != NULL ? 2U * col[i]->len + 2U : 0U;
+	}
+	if (UNLIKELY((op = bp = out_room(z)) == NULL)) {
+		return;
+	}
+	for (size_t i = 0U; i < DLM_NCOL; i++) {
+		const struct fld_s *f = col[i];
+
+		if (i) {
+			*op++ = sep;
+		}
+		if (f == NULL) {
+			op = !csvp
+				? tsv_fld(op, r->lang, lz)
+				: csv_fld(op, r->lang, lz);
+		} else if (!row_fldp(r, f)) {
+			;
+		} else if (f == &r->name) {
+			op = !csvp
+				? tsv_name(op, fld_ptr(f), f->len)
+				: csv_name(op, fld_ptr(f), f->len);
+		} else {
+			op = !csvp
+				? tsv_fld(op, fld_ptr(f), f->len)
+				: csv_fld(op, fld_ptr(f), f->len);
+		}
+	}
+	*op++ = '\n';
+	out->bix += op - bp;
+	return;
+}
+
+
+/* ndjson, one self-contained object per record and line, keys as
+ * in the delimited outputs */
+#define JSON_LD(_x)	"{\"@id\":\"" _x "\",\"@type\":\"xsd:dateTime\"}"
+
+/* whether to begin with a line holding the json-ld context */
+static bool ldp;
+
+static char*
+json_str(char *op, const char *s, size_t z, bool nwsp)
+{
+/* copy S to OP as json string contents, normalising whitespace
+ * like the rdf outputs do if NWSP */
+	static const char hex[] = "0123456789abcdef";
+	const char *sp = !nwsp ? s : skip_ws(s, s + z), *const ep = s + z;
+
+	for (const char *tp;; sp = tp + 1U) {
+		tp = esc_scan_json(sp, ep);
+		memcpy(op, sp, tp - sp);
+		op += tp - sp;
+		if (tp >= ep) {
+			break;
+		} else if (nwsp && (*tp == '\t' || *tp == '\n' || *tp == '\f')) {
+			*op++ = ' ';
+			continue;
+		}
+		*op++ = '\\';
+		switch (*tp) {
+		case '"':
+		case '\\':
+			*op++ = *tp;
+			break;
+		case '\n':
+			*op++ = 'n';
+			break;
+		case '\r':
+			*op++ = 'r';
+			break;
+		case '\t':
+			*op++ = 't';
+			break;
+		default:
+			*op++ = 'u';
+			*op++ = '0';
+			*op++ = '0';
+			*op++ = hex[(unsigned char)*tp >> 4U];
+			*op++ = hex[*tp & 0xfU];
+			break;
+		}
+	}
+	return op;
+}
+
+static void
+json_hdr(void)
+{
+	static const char ctx[] = "{\"@context\":{"
+		"\"@base\":\"" NS_LEI "\","
+		"\"xsd\":\"" NS_XSD "\","
+		"\"lei\":\"@id\","
+		"\"name\":\"" NS_LEIROC "LegalName\","
+		"\"legal_form\":\"" NS_LEIROC "LegalForm\","
+		"\"form_code\":\"" NS_LEIROC "EntityLegalFormCode\","
+		"\"other_form\":\"" NS_LEIROC "LegalForm\","
+		"\"jurisdiction\":\"" NS_LEIROC "LegalJurisdiction\","
+		"\"status\":\"" NS_ROV "orgStatus\","
+		"\"initial_registration\":"
+		JSON_LD(NS_LEIROC "InitialRegistrationDate") ","
+		"\"last_update\":"
+		JSON_LD(NS_LEIROC "LastUpdateDate")
+		"}}\n";
+
+	if (ldp) {
+		out_buf_push(ctx, strlenof(ctx));
+	}
+	return;
+}
+
+static void
+json_rec(const struct lei_s *r)
+{
+#define K(_x)	{_x, strlenof(_x)}
+	static const struct {
+		const char *k;
+		size_t z;
+	} key[DLM_NCOL] = {
+		K("{\"lei\":\""), K(",\"name\":\""), K(",\"lang\":\""),
+		K(",\"legal_form\":\""), K(",\"form_code\":\""),
+		K(",\"other_form\":\""), K(",\"jurisdiction\":\""),
+		K(",\"status\":\""), K(",\"initial_registration\":\""),
+		K(",\"last_update\":\""),
+	};
+#undef K
+	/* the keys in order, NULL for the language */
+	const struct fld_s *col[DLM_NCOL] = {
+		&r->lei, &r->name, NULL, &r->form, &r->fcod, &r->ofrm,
+		&r->jrsd, &r->stat, &r->irdate, &r->ludate,
+	};
+	const size_t lz = strlen(r->lang);
+	char *op, *bp;
+	size_t z = 6U * lz + 256U;
+
+	/* room for the whole line, worst case every byte as \uXXXX */
+	for (size_t i = 0U; i < DLM_NCOL; i++) {
+		z += col[i] != NULL ? 6U * col[i]->len : 0U;
+	}
+	if (UNLIKELY((op = bp = out_room(z)) == NULL)) {
+		return;
+	}
+	for (size_t i = 0U; i < DLM_NCOL; i++) {
+		const struct fld_s *f = col[i];
+
+		if (f == NULL ? !lz : !row_fldp(r, f)) {
+			continue;
+		}
+		memcpy(op, key[i].k, key[i].z);
+		op += key[i].z;
+		if (f == NULL) {
+			op = json_str(op, r->lang, lz, false);
+		} else {
+			op = json_str(op, fld_ptr(f), f->len, f == &r->name);
+		}
+		*op++ = '"';
+	}
+	*op++ = '}';
+	*op++ = '\n';
+	out->bix += op - bp;
+	return;
+}
+
+
+/* arrow, rows are collected into record batches and written as arrow
+ * ipc file, with --jobs in no particular order */
+#define ARW_BATCH	(65536U)
+/* lang, form code, jurisdiction and status are dictionary-encoded */
+#define ARW_DICT	(1U << 2U | 1U << 4U | 1U << 6U | 1U << 7U)
+
+static const char *const arw_cols[DLM_NCOL] = {
+	"lei", "name", "lang", "legal_form", "form_code", "other_form",
+	"jurisdiction", "status", "initial_registration", "last_update",
+};
+
+static arrow_t arw;
+static arrow_ipc_t ipc;
+static pthread_mutex_t arw_mtx = PTHREAD_MUTEX_INITIALIZER;
+/* set when rows couldn't be collected */
+static bool arw_lost;
+
+static int
+arw_open(int fd)
+{
+	struct ArrowSchema s;
+
+	if (UNLIKELY((arw = make_arrow(arw_cols, DLM_NCOL, ARW_DICT)) == NULL)) {
+		return -1;
+	} else if (UNLIKELY(arrow_schema(arw, &s) < 0)) {
+		return -1;
+	}
+	ipc = make_arrow_ipc(fd, &s);
+	s.release(&s);
+	return ipc != NULL ? 0 : -1;
+}
+
+static int
+arw_flush(void)
+{
+/* write the rows collected so far as record batch */
+	struct ArrowArray a;
+	int rc;
+
+	if (UNLIKELY(arrow_batch(arw, &a) < 0)) {
+		return -1;
+	}
+	rc = arrow_ipc_write(ipc, &a);
+	a.release(&a);
+	return rc;
+}
+
+static int
+arw_close(void)
+{
+	int rc = -1;
+
+	if (ipc != NULL) {
+		rc = arw_flush() | arrow_ipc_fin(ipc);
+		free_arrow_ipc(ipc);
+	}
+	if (arw != NULL) {
+		free_arrow(arw);
+	}
+	ipc = NULL;
+	arw = NULL;
+	return rc;
+}
+
+static void
+arw_rec(const struct lei_s *r)
+{
+	/* the columns in order, NULL for the language */
+	const struct fld_s *col[DLM_NCOL] = {
+		&r->lei, &r->name, NULL, &r->form, &r->fcod, &r->ofrm,
+		&r->jrsd, &r->stat, &r->irdate, &r->ludate,
+	};
+	const char *v[DLM_NCOL];
+	size_t z[DLM_NCOL];
+	ssize_t n;
+
+	rbuf.bix = 0U;
+	for (size_t i = 0U; i < DLM_NCOL; i++) {
+		const struct fld_s *f = col[i];
+
+		v[i] = NULL;
+		z[i] = 0U;
+		if (f == NULL) {
+			v[i] = *r->lang ? r->lang : NULL;
+			z[i] = strlen(r->lang);
+		} else if (!row_fldp(r, f)) {
+			;
+		} else if (f != &r->name) {
+			v[i] = fld_ptr(f);
+			z[i] = f->len;
+		} else if (LIKELY(obuf_room(&rbuf, f->len) >= 0)) {
+			/* whitespace normalised like everywhere else */
+			v[i] = rbuf.buf;
+			z[i] = nws_copy(rbuf.buf, fld_ptr(f), f->len) - rbuf.buf;
+		}
+	}
+	pthread_mutex_lock(&arw_mtx);
+	if (UNLIKELY((n = arrow_add(arw, v, z)) < 0)) {
+		arw_lost = true;
+	} else if (n >= (ssize_t)ARW_BATCH && UNLIKELY(arw_flush() < 0)) {
+		arw_lost = true;
+	}
+	pthread_mutex_unlock(&arw_mtx);
+	return;
+}
+
+
+/* snapshots, rows are collected from all threads and written at exit
+ * ordered by LEI, a column per field and one for the language */
+#define SNP_NCOL	(NFLDS + 1U)
+/* form code, jurisdiction, status, content date and lang are coded */
+#define SNP_DICT	(1U << FLD_FCOD | 1U << FLD_JRSD | 1U << FLD_STAT | \
+			 1U << FLD_DATE | 1U << NFLDS)
+
+static const char *const snp_cols[SNP_NCOL] = {
+	[FLD_LEI] = "lei",
+	[FLD_NAME] = "name",
+	[FLD_FORM] = "legal_form",
+	[FLD_FCOD] = "form_code",
+	[FLD_OFRM] = "other_form",
+	[FLD_JRSD] = "jurisdiction",
+	[FLD_STAT] = "status",
+	[FLD_DATE] = "content_date",
+	[FLD_IRDATE] = "initial_registration",
+	[FLD_LUDATE] = "last_update",
+	[NFLDS] = "lang",
+};
+
+static snap_t snp;
+static pthread_mutex_t snp_mtx = PTHREAD_MUTEX_INITIALIZER;
+/* set when rows couldn't be collected */
+static bool snp_lost;
+
+static void
+snp_pre(const struct lei_s *r)
+{
+	sdat.bix = 0U;
+	if (r->date.len &&
+	    UNLIKELY(obuf_write(&sdat, fld_ptr(&r->date), r->date.len) < 0)) {
+		snp_lost = true;
+	}
+	return;
+}
+
+static void
+snp_rec(const struct lei_s *r)
+{
+	const char *v[SNP_NCOL];
+	size_t z[SNP_NCOL];
+
+	/* fields as they are, outputs made from the snapshot massage them */
+	for (size_t i = 0U; i < NFLDS; i++) {
+		v[i] = fld_ptr(r->fld + i);
+		z[i] = r->fld[i].len;
+	}
+	/* records don't carry the content date, the preamble does */
+	v[FLD_DATE] = sdat.buf;
+	z[FLD_DATE] = sdat.bix;
+	v[NFLDS] = r->lang;
+	z[NFLDS] = strlen(r->lang);
+
+	pthread_mutex_lock(&snp_mtx);
+	if (UNLIKELY(snap_add(snp, v, z) < 0)) {
+		snp_lost = true;
+	}
+	pthread_mutex_unlock(&snp_mtx);
+	return;
+}
+
+
+/* shards, records go to one of several files after a hash of their
+ * LEI, headers and preambles go to all of them */
+struct shard_s {
+	struct obuf_s out;
+	pthread_mutex_t mtx;
+	char *fn;
+	size_t nrec;
+	uint64_t nbyt;
+};
+
+static struct shard_s *shd;
+static size_t nshd;
+static const char *shd_pfx = "shard-";
+/* set when a shard couldn't be written */
+static atomic_bool shd_lost;
+
+static const char *const shd_ext[] = {
+	[OFMT_TTL] = "ttl",
+	[OFMT_NT] = "nt",
+	[OFMT_NQ] = "nq",
+	[OFMT_TSV] = "tsv",
+	[OFMT_CSV] = "csv",
+	[OFMT_NDJSON] = "ndjson",
+};
+
+static void
+shd_put(struct shard_s *s, size_t nrec)
+{
+/* append what's in the scratch buffer to S */
+	pthread_mutex_lock(&s->mtx);
+	if (UNLIKELY(obuf_write(&s->out, shb.buf, shb.bix) < 0)) {
+		atomic_store(&shd_lost, true);
+	} else if (UNLIKELY(unbufp) && UNLIKELY(obuf_flush(&s->out) < 0)) {
+		atomic_store(&shd_lost, true);
+	}
+	s->nrec += nrec;
+	s->nbyt += shb.bix;
+	pthread_mutex_unlock(&s->mtx);
+	return;
+}
+
+static void
+shd_all(void)
+{
+	if (!shb.bix) {
+		return;
+	}
+	for (size_t i = 0U; i < nshd; i++) {
+		shd_put(shd + i, 0U);
+	}
+	return;
+}
+
+static void
+shd_rec(const struct lei_s *r)
+{
+/* the shard is picked by the LEI's 64-bit FNV-1a hash, stable across
+ * runs, releases and machines */
+	const char *s = fld_ptr(&r->lei);
+	uint64_t h = 0xcbf29ce484222325U;
+
+	for (size_t i = 0U; i < r->lei.len; i++) {
+		h ^= (unsigned char)s[i];
+		h *= 0x100000001b3U;
+	}
+	shd_put(shd + h % nshd, 1U);
+	return;
+}
+
+static void
+shd_free(void)
+{
+	for (size_t i = 0U; i < nshd; i++) {
+		if (shd[i].out.fd >= 0) {
+			obuf_flush(&shd[i].out);
+			close(shd[i].out.fd);
+		}
+		free(shd[i].out.buf);
+		free(shd[i].fn);
+		pthread_mutex_destroy(&shd[i].mtx);
+	}
+	free(shd);
+	shd = NULL;
+	nshd = 0U;
+	return;
+}
+
+static int
+shd_open(size_t n)
+{
+/* open N shards named after SHD_PFX, the shard number and format,
+ * between them they buffer about as much as stdout would */
+	const size_t bz = obufz / n > 65536U ? obufz / n : 65536U;
+	const size_t pz = strlen(shd_pfx);
+	/* prefix, number, dot, extension, \0 */
+	const size_t fz = pz + 20U + 1U + 8U + 1U;
+	int w = 1;
+
+	if (UNLIKELY((shd = calloc(n, sizeof(*shd))) == NULL)) {
+		return -1;
+	}
+	for (nshd = 0U; nshd < n; nshd++) {
+		shd[nshd].out.fd = -1;
+		pthread_mutex_init(&shd[nshd].mtx, NULL);
+	}
+	/* numbers of equal width so the files sort */
+	for (size_t k = n - 1U; k >= 10U; k /= 10U, w++);
+	for (size_t i = 0U; i < n; i++) {
+		struct shard_s *s = shd + i;
+
+		if (UNLIKELY((s->fn = malloc(fz)) == NULL)) {
+			goto fail;
+		}
+		memcpy(s->fn, shd_pfx, pz);
+		if (snprintf(s->fn + pz, fz - pz, "%0*zu.%s",
+			     w, i, shd_ext[ofmt]) >= (int)(fz - pz)) {
+			goto fail;
+		} else if ((s->out.fd = open(s->fn, O_WRONLY | O_CREAT | O_TRUNC,
+				      0666)) < 0) {
+			goto fail;
+		} else if (UNLIKELY((s->out.buf = malloc(bz)) == NULL)) {
+			goto fail;
+		}
+		s->out.bsz = bz;
+	}
+	return 0;
+
+fail:
+	shd_free();
+	return -1;
+}
+
+static int
+shd_close(void)
+{
+/* flush and close all shards, then write the manifest, a line with
+ * file name, records and bytes per shard */
+	static const char mfn[] = "manifest.tsv";
+	const size_t pz = strlen(shd_pfx);
+	int rc = atomic_load(&shd_lost) ? -1 : 0;
+	char *fn;
+	FILE *mf;
+
+	for (size_t i = 0U; i < nshd; i++) {
+		rc |= obuf_flush(&shd[i].out);
+		rc |= close(shd[i].out.fd);
+		shd[i].out.fd = -1;
+	}
+	if (UNLIKELY((fn = malloc(pz + sizeof(mfn))) == NULL)) {
+		rc = -1;
+		goto fre;
+	}
+	memcpy(fn, shd_pfx, pz);
+	memcpy(fn + pz, mfn, sizeof(mfn));
+	if ((mf = fopen(fn, "w")) == NULL) {
+		rc = -1;
+	} else {
+		fputs("shard\tfile\trecords\tbytes\n", mf);
+		for (size_t i = 0U; i < nshd; i++) {
+			fprintf(mf, "%zu\t%s\t%zu\t%ju\n", i, shd[i].fn,
+				shd[i].nrec, (uintmax_t)shd[i].nbyt);
+		}
+		rc |= ferror(mf) ? -1 : 0;
+		rc |= fclose(mf);
+	}
+	free(fn);
+fre:
+	shd_free();
+	return rc;
+}
+
+
+/* output in the chosen format */
+static void
+hdr_print(void)
+{
+	struct obuf_s *o = out;
+
+	if (shd != NULL) {
+		/* every shard gets one */
+		shb.bix = 0U;
+		out = &shb;
+	}
+	switch (ofmt) {
+	case OFMT_TSV:
+	case OFMT_CSV:
+		dlm_hdr();
+		break;
+	case OFMT_NDJSON:
+		json_hdr();
+		break;
+	default:
+		break;
+	}
+	if (shd != NULL) {
+		out = o;
+		shd_all();
+	}
+	return;
+}
+
+static void
+pre_print(const struct lei_s *r)
+{
+	struct obuf_s *o = out;
+
+	if (shd != NULL) {
+		/* every shard gets one */
+		shb.bix = 0U;
+		out = &shb;
+	}
+	switch (ofmt) {
+	case OFMT_TTL:
+		ttl_pre(r);
+		break;
+	case OFMT_NT:
+	case OFMT_NQ:
+		nt_pre(r);
+		break;
+	case OFMT_SNAP:
+		snp_pre(r);
+		break;
+	default:
+		break;
+	}
+	if (shd != NULL) {
+		out = o;
+		shd_all();
+	}
+	return;
+}
+
+static void
+rec_print(const struct lei_s *r)
+{
+	struct obuf_s *o = out;
+
+	if (shd != NULL) {
+		/* the record's shard gets it */
+		shb.bix = 0U;
+		out = &shb;
+	}
+	switch (ofmt) {
+	case OFMT_TTL:
+		ttl_rec(r);
+		break;
+	case OFMT_NT:
+	case OFMT_NQ:
+		nt_rec(r);
+		break;
+	case OFMT_HDT:
+		hdt_rec(r);
+		break;
+	case OFMT_TSV:
+	case OFMT_CSV:
+		dlm_rec(r);
+		break;
+	case OFMT_NDJSON:
+		json_rec(r);
+		break;
+	case OFMT_ARROW:
+		arw_rec(r);
+		break;
+	case OFMT_SNAP:
+		snp_rec(r);
+		break;
+	default:
+		break;
+	}
+	if (shd != NULL) {
+		out = o;
+		shd_rec(r);
+	} else if (UNLIKELY(unbufp)) {
+		/* hand the record downstream right away */
+		obuf_flush(out);
+	}
+	return;
+}
+
+
+/* record ring between the parser and a writer thread */
+#define RING_N	(256U)
+
+struct slot_s {
+	enum {
+		SL_REC,
+		SL_PRE,
+		SL_FLUSH,
+		SL_EOF,
+	} typ;
+	/* fields point into BUF */
+	struct lei_s r;
+	char *buf;
+	size_t bsz;
+};
+
+struct ring_s {
+	struct slot_s s[RING_N];
+	/* next slot to fill, written by the parser only */
+	atomic_size_t head;
+	/* next slot to drain, written by the writer only */
+	atomic_size_t tail;
+	/* for sleeping on a full or empty ring */
+	atomic_bool sleepp;
+	pthread_mutex_t mtx;
+	pthread_cond_t cnd;
+};
+
+/* the ring the parser feeds, if any */
+static __thread struct ring_s *rng;
+
+static void
+ring_wait(struct ring_s *q, atomic_size_t *x, size_t v)
+{
+/* sleep while *X is V */
+	pthread_mutex_lock(&q->mtx);
+	for (;;) {
+		atomic_store(&q->sleepp, true);
+		if (atomic_load(x) != v) {
+			break;
+		}
+		pthread_cond_wait(&q->cnd, &q->mtx);
+	}
+	pthread_mutex_unlock(&q->mtx);
+	return;
+}
+
+static void
+ring_wake(struct ring_s *q)
+{
+	if (atomic_load(&q->sleepp)) {
+		pthread_mutex_lock(&q->mtx);
+		atomic_store(&q->sleepp, false);
+		pthread_cond_broadcast(&q->cnd);
+		pthread_mutex_unlock(&q->mtx);
+	}
+	return;
+}
+
+static int
+ring_push(struct ring_s *q, int typ, const struct lei_s *r)
+{
+/* copy R along with its field bytes into the next free slot */
+	const size_t h = atomic_load_explicit(&q->head, memory_order_relaxed);
+	struct slot_s *s;
+	size_t t;
+
+	/* backpressure */
+	while (h - (t = atomic_load(&q->tail)) >= RING_N) {
+		ring_wait(q, &q->tail, t);
+	}
+	s = q->s + h % RING_N;
+	s->typ = typ;
+	if (r != NULL) {
+		size_t z = 0U;
+
+		for (size_t i = 0U; i < NFLDS; i++) {
+			z += r->fld[i].len;
+		}
+		if (UNLIKELY(z > s->bsz)) {
+			const size_t nu = (z & ~0xfffU) + 4096U;
+			char *b;
+
+			if (UNLIKELY((b = realloc(s->buf, nu)) == NULL)) {
+				return -1;
+			}
+			s->buf = b;
+			s->bsz = nu;
+		}
+		s->r = *r;
+		z = 0U;
+		for (size_t i = 0U; i < NFLDS; i++) {
+			const size_t len = r->fld[i].len;
+
+			memcpy(s->buf + z, fld_ptr(r->fld + i), len);
+			s->r.fld[i].ext = s->buf + z;
+			z += len;
+		}
+	}
+	atomic_store(&q->head, h + 1U);
+	ring_wake(q);
+	return 0;
+}
+
+static void*
+_writer(void *arg)
+{
+	struct ring_s *q = arg;
+
+	out = &sout;
+	for (size_t t = 0U;; t++) {
+		const struct slot_s *s = q->s + t % RING_N;
+
+		while (atomic_load(&q->head) == t) {
+			ring_wait(q, &q->head, t);
+		}
+		switch (s->typ) {
+		case SL_REC:
+			rec_print(&s->r);
+			break;
+		case SL_PRE:
+			pre_print(&s->r);
+			break;
+		case SL_FLUSH:
+			obuf_flush(out);
+			break;
+		case SL_EOF:
+		default:
+			obuf_flush(out);
+			out_free();
+			return NULL;
+		}
+		atomic_store(&q->tail, t + 1U);
+		ring_wake(q);
+	}
+}
+
+static inline void
+emit_pre(const struct lei_s *r)
+{
+	if (nopre && ofmt == OFMT_TTL) {
+		/* some other chunk's done that, decided here as
+		 * nopre is the parsing thread's */
+		return;
+	} else if (rng != NULL) {
+		ring_push(rng, SL_PRE, r);
+		return;
+	}
+	pre_print(r);
+	return;
+}
+
+/* the file converted on this thread while its output is buffered */
+static __thread struct file_s *fcur;
+static void file_spill(struct file_s *f);
+
+static inline void
+emit_rec(const struct lei_s *r)
+{
+	if (rng != NULL) {
+		ring_push(rng, SL_REC, r);
+		return;
+	}
+	rec_print(r);
+	if (UNLIKELY(fcur != NULL) && out->bix >= obufz) {
+		file_spill(fcur);
+	}
+	return;
+}
+
+static inline void
+emit_flush(void)
+{
+	if (rng != NULL) {
+		ring_push(rng, SL_FLUSH, NULL);
+		return;
+	}
+	obuf_flush(out);
+	return;
+}
+
+
+/* our SAX parser */
+static __thread bool pushp;
+static __thread enum {
+	FL_UNK,
+	FL_CLEIS,
+	FL_PLEIS,
+} flavour;
+/* section of the current record */
+static __thread enum {
+	IN_REC,
+	IN_ENT,
+	IN_REG,
+} where;
+/* namespace of the records */
+static __thread const xmlChar *nsuri;
+/* the builtin tokeniser feeding us, if any */
+static __thread cdftok_t tok;
+/* nesting level within a skipped subtree */
+static __thread unsigned int skipd;
+/* just past the last record the tokeniser got through */
+static __thread const char *rsm;
+/* fields to convert, bit i stands for slot i */
+static unsigned int fldmsk = (1U << NFLDS) - 1U;
+
+static inline bool
+fldp(unsigned int slot)
+{
+	return slot < NFLDS && fldmsk >> slot & 1U;
+}
+
+/* dispatch tables, generated from leitags.def */
+struct tag_s {
+	unsigned int tag;
+	unsigned int slot;
+	unsigned int where;
+};
+
+struct tagtab_s {
+	uint32_t seed;
+	unsigned int shift;
+	const struct tag_s *tag;
+};
+
+#include "leitags.h"
+
+/* tag names, interned in the parser's dictionary,
+ * the extra slot stays NULL for empty table entries */
+static __thread const xmlChar *itag[NTAGS + 1U];
+
+static void
+sax_intern(xmlDictPtr d)
+{
+/* libxml hands us names from D, so after this a pointer comparison
+ * is as good as strcmp() */
+	for (size_t i = 0U; i < NTAGS; i++) {
+		itag[i] = xmlDictLookup(d, (const xmlChar*)tagstr[i], -1);
+	}
+	return;
+}
+
+static inline const struct tag_s*
+tag_find(const struct tagtab_s *tt, const xmlChar *name)
+{
+/* one hash, one comparison */
+	const struct tag_s *t = tt->tag + (tag_hash(name, tt->seed) >> tt->shift);
+
+	return LIKELY(itag[t->tag] == name) ? t : NULL;
+}
+
+static void
+sax_state_reset(void)
+{
+/* reset parser state, in case we bailed out mid-record */
+	flavour = FL_UNK;
+	where = IN_REC;
+	pushp = false;
+	skipd = 0U;
+	rsm = NULL;
+	sax_buf_reset();
+	return;
+}
+
+static xmlEntityPtr
+sax_get_ent(void *UNUSED(ctx), const xmlChar *name)
+{
+	return xmlGetPredefinedEntity(name);
+}
+
+static void
+sax_text(void *UNUSED(ctx), const xmlChar *txt, int len)
+{
+	if (pushp) {
+		sax_span_text((const char*)txt, (size_t)len);
+	}
+	return;
+}
+
+static void
+sax_bo(void *ctx, const xmlChar *name,
+       const xmlChar *UNUSED(prefix), const xmlChar *URI,
+       int UNUSED(nns), const xmlChar **UNUSED(ns),
+       int natts, int UNUSED(ndef), const xmlChar **atts)
+{
+	struct lei_s *r = ctx;
+	const struct tag_s *t;
+
+	if (skipd) {
+		/* libxml doesn't skip, we have to ignore things */
+		skipd++;
+		return;
+	} else if (flavour != FL_UNK && URI != nsuri) {
+		/* not one of ours */
+		return;
+	}
+	switch (flavour) {
+	case FL_UNK:
+		if ((t = tag_find(&unk_tt, name)) == NULL) {
+			break;
+		} else if (t->tag == TAG_LEIRecords) {
+			flavour = FL_CLEIS;
+			nsuri = URI;
+		} else if (t->tag == TAG_LEIRegistrations) {
+			flavour = FL_PLEIS;
+			nsuri = URI;
+		} else {
+			sax_fld_beg(r->fld + t->slot);
+			pushp = true;
+			break;
+		}
+		emit_pre(r);
+		break;
+
+	case FL_CLEIS:
+		if ((t = tag_find(&cleis_tt, name)) == NULL) {
+			/* not interesting */
+			break;
+		} else if (t->where != where) {
+			/* not interesting here */
+			break;
+		}
+		switch (t->tag) {
+		case TAG_Entity:
+			where = IN_ENT;
+			break;
+		case TAG_Registration:
+			where = IN_REG;
+			break;
+		default:
+			if (t->slot == NFLDS) {
+				break;
+			} else if (!fldp(t->slot)) {
+				/* unwanted or skippable, ignore everything
+				 * up to the end tag or have the tokeniser
+				 * jump there right away */
+				skipd = 1U;
+				if (tok != NULL) {
+					cdftok_skip(tok);
+				}
+				break;
+			}
+			sax_fld_beg(r->fld + t->slot);
+			pushp = true;
+			if (t->tag == TAG_LegalName && natts) {
+				/* snarf language tag */
+				goto lang;
+			}
+			break;
+		}
+		break;
+	lang:
+		/* attributes come as (name, prefix, URI, value, end) */
+		for (int i = 0; i < natts; i++, atts += 5U) {
+			if (atts[0U] == itag[TAG_lang]) {
+				const size_t llen = atts[4U] - atts[3U];
+				memcpy(r->lang, atts[3U], llen < 7U ? llen : 7U);
+			}
+		}
+		break;
+
+	case FL_PLEIS:
+		if ((t = tag_find(&pleis_tt, name)) == NULL ||
+		    t->slot >= NFLDS) {
+			break;
+		} else if (!fldp(t->slot)) {
+			skipd = 1U;
+			if (tok != NULL) {
+				cdftok_skip(tok);
+			}
+			break;
+		}
+		sax_fld_beg(r->fld + t->slot);
+		pushp = true;
+		break;
+
+	default:
+		break;
+	}
+	return;
+}
+
+static void
+sax_eo(void *ctx, const xmlChar *name,
+       const xmlChar *UNUSED(prefix), const xmlChar *URI)
 {
-	/* where the real element name starts, sans ns prefix */
-	const char *rname = tag_massage((const char*)name);
 	struct lei_s *r = ctx;
+	const struct tag_s *t;
+
+	if (skipd && --skipd) {
+		/* still inside a skipped subtree */
+		return;
+	} else if (flavour != FL_UNK && URI != nsuri) {
+		/* not one of ours */
+		return;
+	}
+	switch (flavour) {
+	case FL_UNK:
+		if ((t = tag_find(&unk_tt, name)) != NULL && t->slot < NFLDS) {
+			sax_fld_end(r->fld + t->slot, false);
+		}
+		pushp = false;
+		break;
+
+	case FL_CLEIS:
+		if ((t = tag_find(&cleis_tt, name)) == NULL) {
+			/* not interesting */
+			;
+		} else if (t->where == where) {
+			switch (t->tag) {
+			case TAG_LEIRecord:
+				if (r->lei.len) {
+					goto print;
+				}
+				goto reset;
+			case TAG_LEIRecords:
+				goto final;
+			default:
+				if (fldp(t->slot)) {
+					sax_fld_end(r->fld + t->slot, true);
+				}
+				break;
+			}
+		} else if (t->tag == TAG_Entity || t->tag == TAG_Registration) {
+			/* leaving the section */
+			where = IN_REC;
+		}
+		pushp = false;
+		break;
+
+	case FL_PLEIS:
+		if ((t = tag_find(&pleis_tt, name)) == NULL) {
+			/* not interesting */
+			;
+		} else if (t->slot < NFLDS) {
+			if (fldp(t->slot)) {
+				sax_fld_end(r->fld + t->slot, true);
+			}
+		} else if (t->tag == TAG_LEIRegistration) {
+			if (r->lei.len) {
+				goto print;
+			}
+			goto reset;
+		} else if (t->tag == TAG_LEIRegistrations) {
+			goto final;
+		}
+		pushp = false;
+		break;
+
+	default:
+		break;
+
+	print:
+		emit_rec(r);
+
+	reset:
+		memset(r, 0, sizeof(*r));
+		sax_buf_reset();
+		if (tok != NULL && flavour != FL_UNK) {
+			/* libxml could take over from here */
+			rsm = cdftok_at(tok);
+		}
+		break;
+
+	final:
+		/* flush buffer */
+		emit_flush();
+		flavour = FL_UNK;
+		where = IN_REC;
+		pushp = false;
+		goto reset;
+	}
+	return;
+}
+
+
+static xmlSAXHandler hdl = {
+	.initialized = XML_SAX2_MAGIC,
+	.characters = sax_text,
+	.getEntity = sax_get_ent,
+	.startElementNs = sax_bo,
+	.endElementNs = sax_eo,
+};
+
+/* one parser and one dictionary per thread, reused for every input */
+static __thread xmlParserCtxtPtr pctx;
+static __thread xmlSAXHandlerPtr posax;
+static __thread xmlDictPtr tdict;
+
+static xmlParserCtxtPtr
+ctx_get(struct lei_s *r)
+{
+/* return this thread's parser context, reset and with its events
+ * going to R */
+	if (pctx == NULL) {
+		if (UNLIKELY((pctx = xmlNewParserCtxt()) == NULL)) {
+			return NULL;
+		}
+		/* have it call us, like xmlSAXUserParseFile() does */
+		posax = pctx->sax;
+		pctx->sax = &hdl;
+	} else {
+		xmlCtxtReset(pctx);
+	}
+	sax_intern(pctx->dict);
+	sax_state_reset();
+	pctx->userData = r;
+	return pctx;
+}
+
+static int
+ctx_rc(xmlParserCtxtPtr ctxt)
+{
+	return ctxt->wellFormed ? 0 : ctxt->errNo ?: -1;
+}
+
+static int
+ctx_pull(xmlParserCtxtPtr ctxt, xmlInputReadCallback rd, void *rdctx)
+{
+/* parse the document delivered by RD and return the verdict */
+	xmlParserInputBufferPtr ib;
+	xmlParserInputPtr in;
+
+	ib = xmlParserInputBufferCreateIO(
+		rd, NULL, rdctx, XML_CHAR_ENCODING_NONE);
+	if (UNLIKELY(ib == NULL)) {
+		return -1;
+	}
+	in = xmlNewIOInputStream(ctxt, ib, XML_CHAR_ENCODING_NONE);
+	if (UNLIKELY(in == NULL)) {
+		xmlFreeParserInputBuffer(ib);
+		return -1;
+	}
+	inputPush(ctxt, in);
+	xmlParseDocument(ctxt);
+	return ctx_rc(ctxt);
+}
+
+/* largest piece handed to libxml's push parser in one go */
+#define FEED_MAX	(4U * 1024U * 1024U)
+
+static int
+ctx_push(xmlParserCtxtPtr ctxt, const char *buf, size_t len,
+	 const char *ftr, size_t ftrz)
+{
+/* push BUF and then, as the final piece, FTR and return the verdict */
+	for (const char *bp = buf, *const ep = bp + len; bp < ep;) {
+		const size_t z = ep - bp < FEED_MAX ? ep - bp : FEED_MAX;
+
+		if (xmlParseChunk(ctxt, bp, (int)z, 0)) {
+			break;
+		}
+		bp += z;
+	}
+	xmlParseChunk(ctxt, ftr, (int)ftrz, 1);
+	return ctx_rc(ctxt);
+}
+
+static xmlDictPtr
+ctx_dict(void)
+{
+/* return this thread's dictionary for the builtin tokeniser */
+	if (tdict == NULL) {
+		tdict = xmlDictCreate();
+	}
+	return tdict;
+}
+
+static void
+ctx_free(void)
+{
+/* free the thread's parser resources, including sbuf */
+	if (pctx != NULL) {
+		pctx->sax = posax;
+		pctx->userData = pctx;
+		xmlFreeParserCtxt(pctx);
+		pctx = NULL;
+	}
+	if (tdict != NULL) {
+		xmlDictFree(tdict);
+		tdict = NULL;
+	}
+	sax_buf_free();
+	return;
+}
+
+/* push parser mode, size of the pieces we read and feed */
+#define PUSH_DEF	(64U * 1024U)
+static size_t pushz;
+
+static int
+unz_rd(void *ctx, char *buf, int len)
+{
+	return (int)unz_read(ctx, buf, len);
+}
+
+static unz_t
+open_unz(const char *file, int *fd)
+{
+/* open FILE, or stdin if NULL, and have it inflated if need be */
+	unz_t u;
+
+	if (file == NULL || !strcmp(file, "-")) {
+		*fd = STDIN_FILENO;
+	} else if ((*fd = open(file, O_RDONLY)) < 0) {
+		return NULL;
+	}
+	if ((u = make_unz(*fd)) == NULL && *fd != STDIN_FILENO) {
+		close(*fd);
+	}
+	return u;
+}
+
+static int
+close_unz(unz_t u, int fd)
+{
+	const int rc = free_unz(u);
+
+	if (fd != STDIN_FILENO) {
+		close(fd);
+	}
+	return rc;
+}
+
+static int
+_parse_push(const char *file)
+{
+/* read FILE in pieces of PUSHZ bytes and feed them to libxml's push
+ * parser, records are emitted as soon as their closing tag is seen */
+	struct lei_s r[1U] = {0};
+	xmlParserCtxtPtr ctxt;
+	char *buf;
+	ssize_t nrd;
+	unz_t u;
+	int fd;
+	int rc = -1;
+
+	if ((u = open_unz(file, &fd)) == NULL) {
+		return -1;
+	} else if (UNLIKELY((buf = malloc(pushz)) == NULL)) {
+		goto clo;
+	} else if (UNLIKELY((ctxt = ctx_get(r)) == NULL)) {
+		goto fre;
+	} else if (xmlCtxtResetPush(ctxt, NULL, 0, file, NULL) < 0) {
+		goto fre;
+	}
+	do {
+		if (UNLIKELY((nrd = unz_read(u, buf, pushz)) < 0)) {
+			break;
+		}
+	} while (!xmlParseChunk(ctxt, buf, (int)nrd, !nrd) && nrd > 0);
+	rc = ctx_rc(ctxt) ?: nrd < 0 ? -1 : 0;
+
+fre:
+	free(buf);
+clo:
+	rc = close_unz(u, fd) ?: rc;
+	return rc;
+}
+
+static int
+_parse(const char *file)
+{
+	struct lei_s r[1U] = {0};
+	xmlParserCtxtPtr ctxt;
+	unz_t u;
+	int fd;
+	int rc = -1;
+
+	if (pushz) {
+		/* we do the reading */
+		return _parse_push(file);
+	} else if ((u = open_unz(file, &fd)) == NULL) {
+		return -1;
+	}
+	/* libxml pulls, inflated if need be */
+	if (LIKELY((ctxt = ctx_get(r)) != NULL)) {
+		rc = ctx_pull(ctxt, unz_rd, u);
+	}
+	rc = close_unz(u, fd) ?: rc;
+	return rc;
+}
+
+
+/* memory-mapped input */
+static bool mmapp;
+
+/* which parser to use on mapped input */
+static enum {
+	PARSER_AUTO,
+	PARSER_LIBXML,
+	PARSER_BUILTIN,
+} parser;
+
+static char*
+map_file(const char *file, size_t *len)
+{
+/* map FILE and return its contents, or NULL if FILE isn't mappable */
+	struct stat st;
+	char *buf;
+	int fd;
+
+	if (file == NULL || (fd = open(file, O_RDONLY)) < 0) {
+		return NULL;
+	} else if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+		   st.st_size <= 0) {
+		close(fd);
+		return NULL;
+	}
+	buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (UNLIKELY(buf == MAP_FAILED)) {
+		return NULL;
+	} else if (unz_magicp(buf, st.st_size)) {
+		/* compressed, needs to be streamed through the inflater */
+		munmap(buf, st.st_size);
+		return NULL;
+	}
+	/* we go front to back, once */
+	(void)madvise(buf, st.st_size, MADV_SEQUENTIAL);
+#if defined MADV_HUGEPAGE
+	(void)madvise(buf, st.st_size, MADV_HUGEPAGE);
+#endif	/* MADV_HUGEPAGE */
+	*len = st.st_size;
+	return buf;
+}
+
+struct mem_s {
+	const char *buf;
+	size_t len;
+};
+
+static int
+mem_read(void *ctx, char *buf, int len)
+{
+	struct mem_s *m = ctx;
+	const size_t z = m->len < (size_t)len ? m->len : (size_t)len;
+
+	memcpy(buf, m->buf, z);
+	m->buf += z;
+	m->len -= z;
+	return (int)z;
+}
+
+static int
+_parse_mem(const char *buf, size_t len)
+{
+	struct lei_s r[1U] = {0};
+	struct mem_s m = {buf, len};
+	xmlParserCtxtPtr ctxt;
+
+	if (UNLIKELY((ctxt = ctx_get(r)) == NULL)) {
+		return -1;
+	}
+	/* hand out the mapping in libxml-sized pieces, no syscalls */
+	return ctx_pull(ctxt, mem_read, &m);
+}
+
+static int
+_parse_cat(const char *hdr, size_t hdrz, const char *buf, size_t len,
+	   const char *ftr, size_t ftrz)
+{
+/* have libxml parse HDR, BUF and FTR as one document */
+	struct lei_s r[1U] = {0};
+	xmlParserCtxtPtr ctxt;
+
+	if (UNLIKELY((ctxt = ctx_get(r)) == NULL)) {
+		return -1;
+	} else if (xmlCtxtResetPush(ctxt, hdr, (int)hdrz, NULL, NULL)) {
+		return -1;
+	}
+	return ctx_push(ctxt, buf, len, ftr, ftrz);
+}
+
+static const char *find_rec(const char *buf, size_t len, size_t *qlen);
+
+static int
+_parse_tok(const char *buf, size_t len)
+{
+	struct lei_s r[1U] = {0};
+	xmlDictPtr d;
+	int rc = -1;
+
+	if (UNLIKELY((d = ctx_dict()) == NULL)) {
+		return -1;
+	}
+	sax_intern(d);
+	sax_state_reset();
+	if (LIKELY((tok = make_cdftok(&hdl, r, d)) != NULL)) {
+		/* the mapping outlives the records */
+		inb = buf;
+		ine = buf + len;
+		if ((rc = cdftok_parse(tok, buf, len)) == 0) {
+			/* a truncated file is no file */
+			rc = cdftok_fin(tok);
+		}
+		free_cdftok(tok);
+		tok = NULL;
+		inb = ine = NULL;
+	}
+	if (rc < 0 && parser == PARSER_AUTO) {
+		/* beyond the tokeniser, have libxml redo the header and
+		 * carry on after the last record that made it through */
+		const char *rb;
+		size_t hz;
+		size_t qz;
+
+		hz = (rb = find_rec(buf, len, &qz)) != NULL ? rb - buf : len;
+		rb = rsm ?: buf + hz;
+		/* the preamble's out if the records have been reached */
+		nopre = rsm != NULL || flavour != FL_UNK;
+		rc = _parse_cat(buf, hz, rb, buf + len - rb, NULL, 0U);
+		nopre = false;
+	}
+	return rc;
+}
+
+static int
+_parse_map(const char *file)
+{
+	size_t len;
+	char *buf;
+	int rc;
+
+	if ((buf = map_file(file, &len)) == NULL) {
+		/* let libxml deal with it */
+		return _parse(file);
+	} else if (parser != PARSER_LIBXML && cdftok_okp(buf, len)) {
+		rc = _parse_tok(buf, len);
+	} else if (mmapp) {
+		rc = _parse_mem(buf, len);
+	} else {
+		munmap(buf, len);
+		return _parse(file);
+	}
+	munmap(buf, len);
+	return rc;
+}
+
+
+/* snapshot input, rows are replayed as records */
+static int
+_parse_snap(smap_t m)
+{
+/* emit M's rows, preceded by a preamble whenever the content date
+ * changes, as the parser would */
+	ssize_t col[SNP_NCOL];
+	struct lei_s r[1U];
+	const char *cd = NULL;
+	size_t cdz = 0U;
+
+	for (size_t j = 0U; j < SNP_NCOL; j++) {
+		/* the language comes with the name */
+		const unsigned int slot = j < NFLDS ? j : FLD_NAME;
 
-	switch (flavour) {
-	case FL_UNK:
-		if (!strcmp((const char*)name, "lei:ContentDate")) {
-			r->dlen = sbix - r->date;
-		}
-		pushp = false;
-		break;
+		col[j] = fldp(slot) ? smap_col(m, snp_cols[j]) : -1;
+	}
+	for (size_t i = 0U, n = smap_nrow(m); i < n; i++) {
+		const char *s;
+		size_t z;
 
-	case FL_CLEIS:
-		if (in_ent_p) {
-			if (0) {
-				;
-			} else if (!strcmp(rname, "LegalName")) {
-				r->nlen = sbix - r->name;
-			} else if (!strcmp(rname, "LegalForm")) {
-				r->flen = sbix - r->form;
-			} else if (!strcmp(rname, "OtherLegalForm")) {
-				r->olen = sbix - r->ofrm;
-			} else if (!strcmp(rname, "EntityLegalFormCode")) {
-				r->clen = sbix - r->fcod;
-			} else if (!strcmp(rname, "LegalJurisdiction")) {
-				r->jlen = sbix - r->jrsd;
-			} else if (!strcmp(rname, "EntityStatus")) {
-				r->slen = sbix - r->stat;
-			} else if (!strcmp(rname, "Entity")) {
-				in_ent_p = false;
-			}
-		} else if (in_reg_p) {
-			if (0) {
-				;
-			} else if (!strcmp(rname, "InitialRegistrationDate")) {
-				r->irdlen = sbix - r->irdate;
-			} else if (!strcmp(rname, "LastUpdateDate")) {
-				r->ludlen = sbix - r->ludate;
-			} else if (!strcmp(rname, "Registration")) {
-				in_reg_p = false;
-			}
-		} else if (!strcmp(rname, "LEI")) {
-			r->llen = sbix - r->lei;
-		} else if (!strcmp(rname, "LEIRecord")) {
-			if (r->llen) {
-				goto print;
+		memset(r, 0, sizeof(*r));
+		for (size_t j = 0U; j < NFLDS; j++) {
+			if (col[j] >= 0 &&
+			    (s = smap_val(m, i, col[j], &z)) != NULL) {
+				r->fld[j].ext = s;
+				r->fld[j].len = z;
 			}
-			goto reset;
-		} else if (!strcmp(rname, "LEIRecords")) {
-			goto final;
 		}
-		pushp = false;
-		break;
+		if (col[NFLDS] >= 0 &&
+		    (s = smap_val(m, i, col[NFLDS], &z)) != NULL) {
+			memcpy(r->lang, s, z < 7U ? z : 7U);
+		}
+		if (cd == NULL || r->date.len != cdz ||
+		    (cdz && memcmp(r->date.ext, cd, cdz))) {
+			emit_pre(r);
+			cd = r->date.ext ?: "";
+			cdz = r->date.len;
+		}
+		r->date = (struct fld_s){0};
+		emit_rec(r);
+	}
+	emit_flush();
+	return 0;
+}
 
-	case FL_PLEIS:
-		if (!strcmp(rname, "LegalEntityIdentifier")) {
-			r->llen = sax_buf_massage(r->lei) - r->lei;
-		} else if (!strcmp(rname, "RegisteredName")) {
-			r->nlen = sax_buf_massage(r->name) - r->name;
-		} else if (!strcmp(rname, "EntityLegalForm")) {
-			r->flen = sax_buf_massage(r->form) - r->form;
-		} else if (!strcmp(rname, "RegisteredCountryCode")) {
-			r->jlen = sax_buf_massage(r->jrsd) - r->jrsd;
-		} else if (!strcmp(rname, "LEIRegistration")) {
-			if (r->llen) {
-				goto print;
+static int
+_parse_one(const char *file)
+{
+	smap_t m;
+
+	if ((m = smap_open(file)) != NULL) {
+		/* converted before, no parsing needed */
+		const int rc = _parse_snap(m);
+
+		smap_close(m);
+		return rc;
+	}
+	return mmapp || parser != PARSER_LIBXML
+		? _parse_map(file)
+		: _parse(file);
+}
+
+
+/* chunked conversion of one file using multiple threads */
+#define CHUNK_MIN	(16U * 1024U * 1024U)
+
+static size_t njobs = 1U;
+/* whether to write on a separate thread without --jobs */
+static bool pipep;
+
+struct chunk_s {
+	const char *beg;
+	size_t len;
+	/* the chunk's turtle, filled by the worker */
+	struct obuf_s out;
+	int rc;
+	bool donep;
+};
+
+static struct {
+	/* everything before the first and after the last record */
+	const char *hdr;
+	size_t hdrz;
+	const char *ftr;
+	size_t ftrz;
+	struct chunk_s *c;
+	size_t nc;
+	/* whether to use the builtin tokeniser */
+	bool tokp;
+	/* next chunk to hand out */
+	size_t next;
+	/* chunks written out so far */
+	size_t nwr;
+	pthread_mutex_t mtx;
+	pthread_cond_t cnd;
+} par = {
+	.mtx = PTHREAD_MUTEX_INITIALIZER,
+	.cnd = PTHREAD_COND_INITIALIZER,
+};
+
+static const char*
+find_rec(const char *buf, size_t len, size_t *qlen)
+{
+/* find the opening tag of the first record, return a pointer to its '<'
+ * and the length of its (qualified) name in QLEN */
+	static const char *const rtag[] = {"LEIRecord>", "LEIRegistration>"};
+
+	for (size_t i = 0U; i < countof(rtag); i++) {
+		const size_t rz = strlen(rtag[i]);
+		const char *p = buf;
+
+		while ((p = xmemmem(p, buf + len - p, rtag[i], rz)) != NULL) {
+			const char *q;
+
+			/* go back to the beginning of the tag name */
+			for (q = p; q > buf && q[-1] != '<' && q[-1] != '/' &&
+				     q[-1] != '>' && (unsigned char)q[-1] > ' ';
+			     q--);
+			if (q > buf && q[-1] == '<' && (q == p || p[-1] == ':')) {
+				*qlen = p + rz - 1U - q;
+				return q - 1;
 			}
-			goto reset;
-		} else if (!strcmp(rname, "LEIRegistrations")) {
-			goto final;
+			p += rz;
 		}
-		pushp = false;
-		break;
+	}
+	return NULL;
+}
 
-	default:
-		break;
+static int
+_split(const char *buf, size_t len)
+{
+	const char *rb, *re;
+	char ctag[80U];
+	size_t ctz;
+	size_t qz;
 
-	print:
-		/* provenance service */
-		if (r->ludlen) {
-			static const char pre[] = "\
-@prefix MODD: <", post[] = "> .\n";
+	if ((rb = find_rec(buf, len, &qz)) == NULL) {
+		return -1;
+	} else if (qz + 3U >= sizeof(ctag)) {
+		return -1;
+	}
+	/* construct closing tag */
+	ctag[0U] = '<';
+	ctag[1U] = '/';
+	memcpy(ctag + 2U, rb + 1U, qz);
+	ctag[qz + 2U] = '>';
+	ctz = qz + 3U;
+
+	/* find the last closing tag, from the back */
+	for (re = buf + len - ctz; re >= rb; re--) {
+		if (*re == '<' && !memcmp(re, ctag, ctz)) {
+			break;
+		}
+	}
+	if (UNLIKELY(re < rb)) {
+		return -1;
+	}
+	re += ctz;
+
+	par.hdr = buf;
+	par.hdrz = rb - buf;
+	par.ftr = re;
+	par.ftrz = buf + len - re;
+
+	/* chop the records into roughly equal pieces */
+	par.nc = (re - rb) / CHUNK_MIN;
+	if (par.nc < njobs) {
+		par.nc = njobs;
+	}
+	if (UNLIKELY((par.c = calloc(par.nc, sizeof(*par.c))) == NULL)) {
+		return -1;
+	}
+	{
+		const size_t step = (re - rb) / par.nc;
+		const char *cb = rb;
+		size_t nc = 0U;
 
-			out_buf_push(pre, strlenof(pre));
-			out_buf_push(sbuf + r->ludate, r->ludlen);
-			out_buf_push(post, strlenof(post));
-		}
-		/* principal type info */
-		out_buf_push("lei:", 4U);
-		out_buf_push(sbuf + r->lei, r->llen);
-		out_buf_push(" a leiroc:LEI ", 14U);
-
-		static const char lei[] =
-			", fibo-be-le-lei:LegalEntityIdentifier ";
-		static const char cce[] =
-			", fibo-be-le-lei:ContractuallyCapableEntity ";
-		out_buf_push(lei, strlenof(lei));
-		out_buf_push(cce, strlenof(cce));
-
-		static const char sof[] =
-			";\n   gas:symbolOf <http://openleis.com/> ";
-
-		out_buf_push(sof, strlenof(sof));
-
-		if (r->nlen) {
-			static const char tag[] = "leiroc:LegalName";
-			
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(tag, strlenof(tag));
-			out_buf_push(" \"\"\"", 4U);
-			out_buf_push_esc_nws(sbuf + r->name, r->nlen);
-			if (!*r->lang) {
-				out_buf_push("\"\"\" ", 4U);
+		for (size_t k = 1U; k <= par.nc && cb < re; k++) {
+			const char *ce = rb + k * step;
+
+			if (k == par.nc) {
+				ce = re;
+			} else if (ce < cb) {
+				ce = cb;
+			}
+			if (ce >= re ||
+			    (ce = xmemmem(ce, re - ce, ctag, ctz)) == NULL) {
+				ce = re;
 			} else {
-				out_buf_push("\"\"\"@", 4U);
-				out_buf_push(r->lang, strlen(r->lang));
+				ce += ctz;
 			}
+			par.c[nc].beg = cb;
+			par.c[nc].len = ce - cb;
+			par.c[nc].out.fd = -1;
+			nc++;
+			cb = ce;
 		}
-		if (r->irdlen) {
-			static const char tag[] = "leiroc:InitialRegistrationDate";
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(tag, strlenof(tag));
-			out_buf_push(" \"", 2U);
-			out_buf_push(sbuf + r->irdate, r->irdlen);
-			out_buf_push("\"^^xsd:dateTime ", 16U);
-		}
-		if (r->ludlen) {
-			static const char tag[] = "leiroc:LastUpdateDate";
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(tag, strlenof(tag));
-			out_buf_push(" \"", 2U);
-			out_buf_push(sbuf + r->ludate, r->ludlen);
-			out_buf_push("\"^^xsd:dateTime ", 16U);
-		}
-		if (r->clen && sbuf[r->fcod] != '<') {
-			/* append legal form */
-			static const char tag[] = "leiroc:EntityLegalFormCode";
-
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(tag, strlenof(tag));
-			out_buf_push(" \"", 2U);
-			out_buf_push_esc(sbuf + r->fcod, r->clen);
-			out_buf_push("\" ", 2U);
-		}
-		if (r->olen && sbuf[r->ofrm] != '<') {
-			/* append legal form */
-			static const char tag[] = "leiroc:LegalForm";
-			static const char typ[] = "rov:orgType";
-			static const char fpre[] = "http://openleis.com/legal_entities/search/legal_form/";
-
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(tag, strlenof(tag));
-			out_buf_push(" \"\"\"", 4U);
-			out_buf_push_esc(sbuf + r->ofrm, r->olen);
-			out_buf_push("\"\"\" ", 4U);
+		par.nc = nc;
+	}
+	par.next = 0U;
+	par.nwr = 0U;
+	return 0;
+}
 
-			/* and as rov:orgType */
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(typ, strlenof(typ));
-			out_buf_push(" <", 2U);
-			out_buf_push(fpre, strlenof(fpre));
-			out_buf_push_iri(sbuf + r->ofrm, r->olen);
-			out_buf_push("> ", 2U);
-		}
-		if (r->flen && !(r->olen || r->clen) && sbuf[r->form] != '<') {
-			/* append legal form */
-			static const char tag[] = "leiroc:LegalForm";
-			static const char typ[] = "rov:orgType";
-			static const char fpre[] = "http://openleis.com/legal_entities/search/legal_form/";
-
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(tag, strlenof(tag));
-			out_buf_push(" \"\"\"", 4U);
-			out_buf_push_esc(sbuf + r->form, r->flen);
-			out_buf_push("\"\"\" ", 4U);
+static int
+_parse_chunk(struct chunk_s *c, bool firstp)
+{
+	struct lei_s r[1U] = {0};
+	int rc = -1;
 
-			/* and as rov:orgType */
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(typ, strlenof(typ));
-			out_buf_push(" <", 2U);
-			out_buf_push(fpre, strlenof(fpre));
-			out_buf_push_iri(sbuf + r->form, r->flen);
-			out_buf_push("> ", 2U);
-		}
-		if (r->jlen) {
-			/* append legal form */
-			static const char tag[] = "leiroc:LegalJurisdiction";
-			static const char jur[] = "http://schema.ga-group.nl/jurisdictions#";
-
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(tag, strlenof(tag));
-			out_buf_push(" \"\"\"", 4U);
-			out_buf_push_esc(sbuf + r->jrsd, r->jlen);
-			out_buf_push("\"\"\" ", 4U);
+	out = &c->out;
+	/* only the first chunk emits the preamble */
+	nopre = !firstp;
+	if (par.tokp) {
+		/* chunks start and end outside of markup, so we can
+		 * tokenise header, records and footer one by one */
+		xmlDictPtr d;
 
-			/* and again as fibo-be-le-lei statement */
-			out_buf_push(";\n   ", 5U);
-			out_buf_push("fibo-be-le-lei:isRecognizedIn", 29U);
-			out_buf_push(" <", 2U);
-			out_buf_push(jur, strlenof(jur));
-			out_buf_push_iri(sbuf + r->jrsd, r->jlen);
-			out_buf_push("> ", 2U);
+		if (UNLIKELY((d = ctx_dict()) == NULL)) {
+			goto clo;
 		}
+		sax_intern(d);
+		if (LIKELY((tok = make_cdftok(&hdl, r, d)) != NULL)) {
+			/* header, chunks and footer are all in the mapping */
+			inb = par.hdr;
+			ine = par.ftr + par.ftrz;
+			if ((rc = cdftok_parse(tok, par.hdr, par.hdrz)) < 0 ||
+			    (rc = cdftok_parse(tok, c->beg, c->len)) < 0) {
+				;
+			} else if ((rc = cdftok_parse(tok, par.ftr,
+						       par.ftrz)) == 0) {
+				/* the footer has to complete the document */
+				rc = cdftok_fin(tok);
+			}
+			free_cdftok(tok);
+			tok = NULL;
+			inb = ine = NULL;
+		}
+		if (rc < 0 && parser == PARSER_AUTO) {
+			/* carry on with libxml after the last record
+			 * the tokeniser got through */
+			const char *rb = rsm ?: c->beg;
 
-		if (r->slen) {
-			/* append status */
-			static const char tag[] = "rov:orgStatus";
-			out_buf_push(";\n   ", 5U);
-			out_buf_push(tag, strlenof(tag));
-			out_buf_push(" \"", 2U);
-			out_buf_push(sbuf + r->stat, r->slen);
-			out_buf_push("\" ", 2U);
+			nopre = nopre || rsm != NULL || flavour != FL_UNK;
+			rc = _parse_cat(par.hdr, par.hdrz,
+					rb, c->beg + c->len - rb,
+					par.ftr, par.ftrz);
 		}
+		goto clo;
+	}
+	rc = _parse_cat(par.hdr, par.hdrz, c->beg, c->len, par.ftr, par.ftrz);
 
-		out_buf_push(".\n", 2U);
+clo:
+	out = NULL;
+	sax_state_reset();
+	return rc;
+}
 
-	reset:
-		memset(r, 0, sizeof(*r));
-		sax_buf_reset();
-		break;
+static void*
+_worker(void *UNUSED(arg))
+{
+	for (size_t i;;) {
+		int rc;
 
-	final:
-		/* flush buffer */
-		fflush(stdout);
-		flavour = FL_UNK;
-		in_ent_p = false;
-		in_reg_p = false;
-		pushp = false;
-		goto reset;
+		pthread_mutex_lock(&par.mtx);
+		i = par.next++;
+		/* backpressure, stay at most 2 chunks per job ahead
+		 * of the writer so converted chunks don't pile up */
+		while (i < par.nc && i >= par.nwr + 2U * njobs) {
+			pthread_cond_wait(&par.cnd, &par.mtx);
+		}
+		pthread_mutex_unlock(&par.mtx);
+
+		if (i >= par.nc) {
+			break;
+		}
+		rc = _parse_chunk(par.c + i, !i);
+
+		pthread_mutex_lock(&par.mtx);
+		par.c[i].rc = rc;
+		par.c[i].donep = true;
+		pthread_cond_broadcast(&par.cnd);
+		pthread_mutex_unlock(&par.mtx);
 	}
-	return;
+	ctx_free();
+	out_free();
+	return NULL;
+}
+
+static int
+_parse_piped(const char *file)
+{
+/* parse FILE on this thread and have another one write the turtle */
+	struct ring_s *q;
+	pthread_t th;
+	int rc;
+
+	if (UNLIKELY((q = calloc(1U, sizeof(*q))) == NULL)) {
+		return _parse_one(file);
+	}
+	pthread_mutex_init(&q->mtx, NULL);
+	pthread_cond_init(&q->cnd, NULL);
+	if (UNLIKELY(pthread_create(&th, NULL, _writer, q))) {
+		rc = _parse_one(file);
+		goto fre;
+	}
+	rng = q;
+	rc = _parse_one(file);
+	ring_push(q, SL_EOF, NULL);
+	rng = NULL;
+	pthread_join(th, NULL);
+
+fre:
+	for (size_t i = 0U; i < countof(q->s); i++) {
+		free(q->s[i].buf);
+	}
+	pthread_cond_destroy(&q->cnd);
+	pthread_mutex_destroy(&q->mtx);
+	free(q);
+	return rc;
+}
+
+static int
+_parse_par(const char *file)
+{
+	pthread_t *th;
+	size_t nth = 0U;
+	size_t len;
+	char *buf;
+	int rc = -1;
+
+	if (pushz) {
+		/* asked to read in pieces, nothing to split then */
+		return _parse_piped(file);
+	} else if ((buf = map_file(file, &len)) == NULL) {
+		/* can't be split, at least write on another thread */
+		return _parse_piped(file);
+	} else if (snap_magicp(buf, len)) {
+		/* nothing to parse, let alone split */
+		munmap(buf, len);
+		return _parse_piped(file);
+	} else if (_split(buf, len) < 0) {
+		/* no records to split at, do it the old-fashioned way */
+		munmap(buf, len);
+		return _parse_piped(file);
+	}
+	par.tokp = parser != PARSER_LIBXML && cdftok_okp(buf, len);
+
+	if (UNLIKELY((th = calloc(njobs, sizeof(*th))) == NULL)) {
+		goto fre;
+	}
+	for (; nth < njobs && nth < par.nc; nth++) {
+		if (pthread_create(th + nth, NULL, _worker, NULL)) {
+			break;
+		}
+	}
+	if (UNLIKELY(!nth)) {
+		goto fre;
+	}
+	/* write chunks in order, as they become available */
+	rc = 0;
+	for (size_t i = 0U; i < par.nc; i++) {
+		pthread_mutex_lock(&par.mtx);
+		while (!par.c[i].donep) {
+			pthread_cond_wait(&par.cnd, &par.mtx);
+		}
+		pthread_mutex_unlock(&par.mtx);
+
+		obuf_write(&sout, par.c[i].out.buf, par.c[i].out.bix);
+		free(par.c[i].out.buf);
+		if (par.c[i].rc && !rc) {
+			rc = par.c[i].rc;
+		}
+
+		pthread_mutex_lock(&par.mtx);
+		par.nwr = i + 1U;
+		pthread_cond_broadcast(&par.cnd);
+		pthread_mutex_unlock(&par.mtx);
+	}
+	obuf_flush(&sout);
+	for (size_t i = 0U; i < nth; i++) {
+		pthread_join(th[i], NULL);
+	}
+
+fre:
+	free(th);
+	free(par.c);
+	par.c = NULL;
+	par.nc = 0U;
+	munmap(buf, len);
+	return rc;
 }
 
 
-static xmlSAXHandler hdl = {
-	.characters = sax_text,
-	.getEntity = sax_get_ent,
-	.startElement = sax_bo,
-	.endElement = sax_eo,
+/* parallel conversion of several files */
+struct file_s {
+	const char *fn;
+	off_t sz;
+	/* the file's turtle, filled by the worker up to OBUFZ bytes */
+	struct obuf_s out;
+	int rc;
+	bool donep;
+	/* queued for its turn on stdout */
+	bool queuedp;
+};
+
+static bool unordp;
+
+static struct {
+	struct file_s *f;
+	size_t nf;
+	/* dispatch order, largest files first */
+	size_t *ord;
+	size_t next;
+	/* indices of files that are converted or whose buffer is full,
+	 * in that order */
+	size_t *fin;
+	size_t nfin;
+	/* the file whose turn it is on stdout */
+	struct file_s *head;
+	pthread_mutex_t mtx;
+	pthread_cond_t cnd;
+} fpar = {
+	.mtx = PTHREAD_MUTEX_INITIALIZER,
+	.cnd = PTHREAD_COND_INITIALIZER,
 };
 
 static int
-_parse(const char *file)
+fsz_cmp(const void *x, const void *y)
 {
-	static struct lei_s r[1U];
-	int rc;
+	const off_t a = fpar.f[*(const size_t*)x].sz;
+	const off_t b = fpar.f[*(const size_t*)y].sz;
+
+	return (a < b) - (a > b);
+}
 
-	rc = xmlSAXUserParseFile(&hdl, r, file ?: "-");
+static void
+file_queue(struct file_s *f)
+{
+/* to be called with the lock held */
+	if (!f->queuedp) {
+		f->queuedp = true;
+		fpar.fin[fpar.nfin++] = f - fpar.f;
+		pthread_cond_broadcast(&fpar.cnd);
+	}
+	return;
+}
 
-	/* free resources */
-	if (LIKELY(sbuf != NULL)) {
-		free(sbuf);
-		sbuf = NULL;
-		sbix = 0U;
-		sbsz = 0U;
+static void
+file_spill(struct file_s *f)
+{
+/* F's buffer is full, wait for F's turn, then write what's buffered
+ * and have the rest of F go to stdout directly */
+	pthread_mutex_lock(&fpar.mtx);
+	file_queue(f);
+	while (fpar.head != f) {
+		pthread_cond_wait(&fpar.cnd, &fpar.mtx);
+	}
+	pthread_mutex_unlock(&fpar.mtx);
+
+	obuf_write(&sout, f->out.buf, f->out.bix);
+	f->out.bix = 0U;
+	out = &sout;
+	fcur = NULL;
+	return;
+}
+
+static void*
+_fworker(void *UNUSED(arg))
+{
+	for (size_t i;;) {
+		struct file_s *f;
+		int rc = -1;
+
+		pthread_mutex_lock(&fpar.mtx);
+		i = fpar.next++;
+		pthread_mutex_unlock(&fpar.mtx);
+
+		if (i >= fpar.nf) {
+			break;
+		}
+		f = fpar.f + fpar.ord[i];
+		out = &f->out;
+		fcur = f;
+		rc = _parse_one(f->fn);
+		fcur = NULL;
+		out = NULL;
+
+		pthread_mutex_lock(&fpar.mtx);
+		f->rc = rc;
+		f->donep = true;
+		file_queue(f);
+		pthread_cond_broadcast(&fpar.cnd);
+		pthread_mutex_unlock(&fpar.mtx);
+	}
+	ctx_free();
+	out_free();
+	return NULL;
+}
+
+static int
+_parse_files(char *const *fns, size_t nf)
+{
+/* convert NF files FNS using a pool of NJOBS threads,
+ * return the number of files that could not be converted */
+	pthread_t *th = NULL;
+	size_t nth = 0U;
+	int rc = 0;
+
+	fpar.f = calloc(nf, sizeof(*fpar.f));
+	fpar.ord = calloc(nf, sizeof(*fpar.ord));
+	fpar.fin = calloc(nf, sizeof(*fpar.fin));
+	th = calloc(njobs, sizeof(*th));
+	if (UNLIKELY(fpar.f == NULL || fpar.ord == NULL ||
+		     fpar.fin == NULL || th == NULL)) {
+		rc = (int)nf;
+		goto fre;
+	}
+	for (size_t i = 0U; i < nf; i++) {
+		struct stat st;
+
+		fpar.f[i].fn = fns[i];
+		fpar.f[i].sz = stat(fns[i], &st) < 0 ? 0 : st.st_size;
+		fpar.f[i].out.fd = -1;
+		fpar.ord[i] = i;
+	}
+	fpar.nf = nf;
+	fpar.next = 0U;
+	fpar.nfin = 0U;
+	fpar.head = NULL;
+	if (unordp) {
+		/* hand out big files first so small ones fill the gaps,
+		 * in order the next file to write must have been handed
+		 * out already or it starves behind full buffers */
+		qsort(fpar.ord, nf, sizeof(*fpar.ord), fsz_cmp);
+	}
+
+	for (; nth < njobs && nth < nf; nth++) {
+		if (pthread_create(th + nth, NULL, _fworker, NULL)) {
+			break;
+		}
+	}
+	if (UNLIKELY(!nth)) {
+		rc = (int)nf;
+		goto fre;
+	}
+	/* write files in argument or completion order, the file whose
+	 * turn it is may write to stdout itself in the meantime */
+	for (size_t i = 0U; i < nf; i++) {
+		struct file_s *f;
+
+		pthread_mutex_lock(&fpar.mtx);
+		if (unordp) {
+			while (fpar.nfin <= i) {
+				pthread_cond_wait(&fpar.cnd, &fpar.mtx);
+			}
+			f = fpar.f + fpar.fin[i];
+		} else {
+			f = fpar.f + i;
+		}
+		fpar.head = f;
+		pthread_cond_broadcast(&fpar.cnd);
+		while (!f->donep) {
+			pthread_cond_wait(&fpar.cnd, &fpar.mtx);
+		}
+		pthread_mutex_unlock(&fpar.mtx);
+
+		obuf_write(&sout, f->out.buf, f->out.bix);
+		obuf_flush(&sout);
+		free(f->out.buf);
+		if (f->rc) {
+			fprintf(stderr, "\
+gleis2rdf: Error: cannot convert `%s'\n", f->fn);
+			rc++;
+		}
 	}
+	for (size_t i = 0U; i < nth; i++) {
+		pthread_join(th[i], NULL);
+	}
+
+fre:
+	free(th);
+	free(fpar.fin);
+	free(fpar.ord);
+	free(fpar.f);
 	return rc;
 }
 
@@ -727,9 +3653,197 @@ main(int argc, char *argv[])
 		goto out;
 	}
 
+	if (argi->jobs_arg) {
+		long int n = strtol(argi->jobs_arg, NULL, 10);
+
+		if (n <= 0) {
+			n = sysconf(_SC_NPROCESSORS_ONLN);
+		}
+		njobs = n > 0 ? n : 1U;
+	} else {
+		/* parse and write on separate cores if there are two */
+		pipep = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+	}
+	mmapp = argi->mmap_flag;
+	if (argi->push_arg == YUCK_OPTARG_NONE) {
+		pushz = PUSH_DEF;
+	} else if (argi->push_arg) {
+		size_t n = strtoz(argi->push_arg);
+
+		pushz = n > 0U && n <= INT_MAX ? n : PUSH_DEF;
+	}
+	if (argi->obuf_arg) {
+		size_t n = strtoz(argi->obuf_arg);
+
+		obufz = n >= 4096U ? n : OBUF_DEF;
+	}
+	unbufp = argi->unbuffered_flag;
+	if (!!argi->ntriples_flag + !!argi->hdt_flag +
+	    !!argi->tsv_flag + !!argi->csv_flag +
+	    !!argi->ndjson_flag + !!argi->jsonld_flag +
+	    !!argi->arrow_flag + !!argi->snapshot_flag +
+	    (argi->nquads_arg != NULL) > 1) {
+		fputs("\
+gleis2rdf: Error: more than one output format given\n", stderr);
+		rc = 1;
+		goto out;
+	}
+	if (argi->ntriples_flag) {
+		ofmt = OFMT_NT;
+	}
+	if (argi->hdt_flag) {
+		ofmt = OFMT_HDT;
+	}
+	if (argi->tsv_flag) {
+		ofmt = OFMT_TSV;
+	}
+	if (argi->csv_flag) {
+		ofmt = OFMT_CSV;
+	}
+	if (argi->ndjson_flag || argi->jsonld_flag) {
+		ofmt = OFMT_NDJSON;
+		ldp = argi->jsonld_flag;
+	}
+	if (argi->arrow_flag) {
+		ofmt = OFMT_ARROW;
+	}
+	if (argi->snapshot_flag) {
+		ofmt = OFMT_SNAP;
+	}
+	if (argi->nquads_arg == NULL) {
+		;
+	} else if (argi->nquads_arg == YUCK_OPTARG_NONE ||
+		   !strcmp(argi->nquads_arg, "ludate")) {
+		ofmt = OFMT_NQ;
+		graph = GRAPH_LUDATE;
+	} else if (!strcmp(argi->nquads_arg, "content")) {
+		ofmt = OFMT_NQ;
+		graph = GRAPH_CONTENT;
+	} else {
+		fprintf(stderr, "\
+gleis2rdf: Error: unknown graph key `%s'\n", argi->nquads_arg);
+		rc = 1;
+		goto out;
+	}
+	if (ofmt == OFMT_HDT && UNLIKELY((hdt = make_hdt()) == NULL)) {
+		rc = 1;
+		goto out;
+	} else if (ofmt == OFMT_SNAP &&
+		   UNLIKELY((snp = make_snap(snp_cols, SNP_NCOL,
+					     SNP_DICT)) == NULL)) {
+		rc = 1;
+		goto out;
+	}
+	if (argi->fields_arg) {
+		static const struct {
+			const char *name;
+			unsigned int msk;
+		} flds[] = {
+			{"lei", 1U << FLD_LEI},
+			{"name", 1U << FLD_NAME},
+			{"form", 1U << FLD_FORM | 1U << FLD_FCOD | 1U << FLD_OFRM},
+			{"jurisdiction", 1U << FLD_JRSD},
+			{"status", 1U << FLD_STAT},
+			{"irdate", 1U << FLD_IRDATE},
+			{"ludate", 1U << FLD_LUDATE},
+		};
+		/* LEIs make the subjects, the content date the preamble */
+		fldmsk = 1U << FLD_LEI | 1U << FLD_DATE;
+		for (char *on, *fp = argi->fields_arg; *fp; fp = on) {
+			size_t j, z;
+
+			if ((on = strchr(fp, ',')) == NULL) {
+				on = fp + strlen(fp);
+			}
+			z = on - fp;
+			on += *on == ',';
+			for (j = 0U; j < countof(flds); j++) {
+				if (!strncmp(fp, flds[j].name, z) &&
+				    !flds[j].name[z]) {
+					fldmsk |= flds[j].msk;
+					break;
+				}
+			}
+			if (j >= countof(flds) && z) {
+				fprintf(stderr, "\
+gleis2rdf: Error: unknown field `%.*s'\n", (int)z, fp);
+				rc = 1;
+				goto out;
+			}
+		}
+	}
+	if (argi->parser_arg == NULL || !strcmp(argi->parser_arg, "auto")) {
+		parser = PARSER_AUTO;
+	} else if (!strcmp(argi->parser_arg, "libxml")) {
+		parser = PARSER_LIBXML;
+	} else if (!strcmp(argi->parser_arg, "builtin")) {
+		parser = PARSER_BUILTIN;
+	} else {
+		fprintf(stderr, "\
+gleis2rdf: Error: unknown parser `%s'\n", argi->parser_arg);
+		rc = 1;
+		goto out;
+	}
+	if (!pushz) {
+		;
+	} else if (mmapp || parser == PARSER_BUILTIN) {
+		fputs("\
+gleis2rdf: Error: --push needs libxml, not --mmap or --parser=builtin\n",
+		      stderr);
+		rc = 1;
+		goto out;
+	} else {
+		/* only libxml can be pushed to */
+		parser = PARSER_LIBXML;
+	}
+
+	if (argi->output_prefix_arg) {
+		shd_pfx = argi->output_prefix_arg;
+	}
+	if (argi->shards_arg) {
+		long int n = strtol(argi->shards_arg, NULL, 10);
+
+		if (ofmt >= countof(shd_ext) || shd_ext[ofmt] == NULL) {
+			fputs("\
+gleis2rdf: Error: cannot shard --hdt, --arrow or --snapshot output\n", stderr);
+			rc = 1;
+			goto out;
+		} else if (n <= 0) {
+			fprintf(stderr, "\
+gleis2rdf: Error: invalid number of shards `%s'\n", argi->shards_arg);
+			rc = 1;
+			goto out;
+		} else if (shd_open(n) < 0) {
+			fprintf(stderr, "\
+gleis2rdf: Error: cannot open shards `%s...'\n", shd_pfx);
+			rc = 1;
+			goto out;
+		}
+	}
+
+	/* main thread writes straight to stdout */
+	out = &sout;
+	/* one header for all FILEs */
+	hdr_print();
+	if (ofmt == OFMT_ARROW && UNLIKELY(arw_open(STDOUT_FILENO) < 0)) {
+		fputs("\
+gleis2rdf: Error: cannot write Arrow\n", stderr);
+		arw_close();
+		rc = 1;
+		goto out;
+	}
+	xmlInitParser();
+
 	/* assume success */
 	rc = 0;
 
+	if (njobs > 1U && argi->nargs > 1U) {
+		/* a file per thread */
+		unordp = argi->unordered_flag;
+		rc = _parse_files(argi->args, argi->nargs);
+		goto fin;
+	}
+
 	/* check if no files have been supplied */
 	i = 0U;
 	if (!argi->nargs) {
@@ -738,14 +3852,54 @@ main(int argc, char *argv[])
 	}
 	for (; i < argi->nargs; i++) {
 	one_off:
-		if (_parse(argi->args[i]) != 0) {
+		if ((njobs > 1U
+		     ? _parse_par(argi->args[i])
+		     : pipep
+		     ? _parse_piped(argi->args[i])
+		     : _parse_one(argi->args[i])) != 0) {
 			fprintf(stderr, "\
 gleis2rdf: Error: cannot convert `%s'\n", argi->args[i]);
 			rc++;
 		}
 	}
 
+	ctx_free();
+	out_free();
+
+fin:
+	if (hdt != NULL) {
+		/* everything's collected, write it in one go */
+		obuf_flush(&sout);
+		if (hdt_lost || hdt_write(hdt, STDOUT_FILENO, NS_LEI) < 0) {
+			fputs("\
+gleis2rdf: Error: cannot write HDT\n", stderr);
+			rc++;
+		}
+		free_hdt(hdt);
+	}
+	if (arw != NULL && (arw_close() < 0 || arw_lost)) {
+		fputs("\
+gleis2rdf: Error: cannot write Arrow\n", stderr);
+		rc++;
+	}
+	if (snp != NULL) {
+		/* all rows are in, order and write them */
+		obuf_flush(&sout);
+		if (snp_lost || snap_write(snp, STDOUT_FILENO) < 0) {
+			fputs("\
+gleis2rdf: Error: cannot write snapshot\n", stderr);
+			rc++;
+		}
+		free_snap(snp);
+	}
+	if (shd != NULL && shd_close() < 0) {
+		fputs("\
+gleis2rdf: Error: cannot write shards\n", stderr);
+		rc++;
+	}
+
 out:
+	obuf_free(&sout);
 	yuck_free(argi);
 	return rc;
 }
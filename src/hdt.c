@@ -0,0 +1,807 @@
+/*** hdt.c -- HDT writer
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include "hdt.h"
+
+#if !defined LIKELY
+# define LIKELY(_x)	__builtin_expect((_x), 1)
+#endif
+#if !defined UNLIKELY
+# define UNLIKELY(_x)	__builtin_expect((_x), 0)
+#endif
+#define countof(_x)	(sizeof(_x) / sizeof(*_x))
+#define strlenof(_x)	(sizeof(_x) - 1U)
+
+/* strings per front-coded block */
+#define PFC_BLKZ	(16U)
+
+/* section types of HDT's control information */
+enum {
+	CI_GLOBAL = 1,
+	CI_HEADER = 2,
+	CI_DICT = 3,
+	CI_TRIPLES = 4,
+};
+
+#define HDT_NS		"http://purl.org/HDT/hdt#"
+#define HDT_V1		"<" HDT_NS "HDTv1>"
+#define HDT_FOUR	"<" HDT_NS "dictionaryFour>"
+#define HDT_BITMAP	"<" HDT_NS "triplesBitmap>"
+
+/* roles of a term */
+#define ROLE_S	(1U)
+#define ROLE_O	(2U)
+
+struct term_s {
+	/* offset into the heap */
+	size_t off;
+	uint32_t len;
+	uint32_t hash;
+	unsigned int role;
+	/* dictionary id, assigned when writing */
+	uint32_t id;
+};
+
+struct strtab_s {
+	struct term_s *t;
+	size_t nt;
+	size_t zt;
+	/* open addressing, slots hold term indices + 1 */
+	uint32_t *idx;
+	size_t zidx;
+	/* the strings */
+	char *heap;
+	size_t hix;
+	size_t hsz;
+};
+
+struct hdt_s {
+	/* subjects and objects, they share ids */
+	struct strtab_s so;
+	/* predicates, numbered separately */
+	struct strtab_s pr;
+	/* triples as term indices, later as ids */
+	uint32_t (*tr)[3U];
+	size_t ntr;
+	size_t ztr;
+};
+
+
+/* checksums, HDT uses CRC-8 (poly 0x07), CRC-16/ARC and CRC-32C */
+static uint8_t crc8_tbl[256U];
+static uint16_t crc16_tbl[256U];
+static uint32_t crc32_tbl[256U];
+
+static void
+crc_init(void)
+{
+	if (crc32_tbl[1U]) {
+		return;
+	}
+	for (unsigned int i = 0U; i < 256U; i++) {
+		uint8_t c8 = (uint8_t)i;
+		uint16_t c16 = (uint16_t)i;
+		uint32_t c32 = i;
+
+		for (unsigned int k = 0U; k < 8U; k++) {
+			c8 = (uint8_t)(c8 << 1U ^ (c8 & 0x80U ? 0x07U : 0U));
+			c16 = (uint16_t)(c16 & 1U ? (c16 >> 1U) ^ 0xa001U : c16 >> 1U);
+			c32 = c32 & 1U ? (c32 >> 1U) ^ 0x82f63b78U : c32 >> 1U;
+		}
+		crc8_tbl[i] = c8;
+		crc16_tbl[i] = c16;
+		crc32_tbl[i] = c32;
+	}
+	return;
+}
+
+
+/* output, with all three checksums maintained along the way */
+struct wr_s {
+	int fd;
+	int rc;
+	uint8_t c8;
+	uint16_t c16;
+	uint32_t c32;
+	size_t n;
+	unsigned char b[65536U];
+};
+
+static void
+wr_flush(struct wr_s *w)
+{
+	for (size_t i = 0U; i < w->n;) {
+		ssize_t nwr = write(w->fd, w->b + i, w->n - i);
+
+		if (UNLIKELY(nwr < 0)) {
+			if (errno == EINTR) {
+				continue;
+			}
+			w->rc = -1;
+			break;
+		}
+		i += nwr;
+	}
+	w->n = 0U;
+	return;
+}
+
+static void
+wr_put(struct wr_s *w, const void *buf, size_t len)
+{
+	const unsigned char *bp = buf;
+
+	for (size_t i = 0U; i < len; i++) {
+		w->c8 = crc8_tbl[w->c8 ^ bp[i]];
+		w->c16 = (uint16_t)((w->c16 >> 8U) ^ crc16_tbl[(w->c16 ^ bp[i]) & 0xffU]);
+		w->c32 = (w->c32 >> 8U) ^ crc32_tbl[(w->c32 ^ bp[i]) & 0xffU];
+	}
+	while (len > 0U) {
+		size_t z = sizeof(w->b) - w->n;
+
+		if (z > len) {
+			z = len;
+		}
+		memcpy(w->b + w->n, bp, z);
+		w->n += z;
+		bp += z;
+		len -= z;
+		if (w->n >= sizeof(w->b)) {
+			wr_flush(w);
+		}
+	}
+	return;
+}
+
+static void
+wr_beg(struct wr_s *w)
+{
+/* start checksumming afresh */
+	w->c8 = 0U;
+	w->c16 = 0U;
+	w->c32 = 0xffffffffU;
+	return;
+}
+
+static void
+wr_crc8(struct wr_s *w)
+{
+	const uint8_t c = w->c8;
+
+	wr_put(w, &c, sizeof(c));
+	return;
+}
+
+static void
+wr_crc16(struct wr_s *w)
+{
+	const uint16_t c = w->c16;
+	const unsigned char b[] = {(unsigned char)c, (unsigned char)(c >> 8U)};
+
+	wr_put(w, b, sizeof(b));
+	return;
+}
+
+static void
+wr_crc32(struct wr_s *w)
+{
+	const uint32_t c = w->c32 ^ 0xffffffffU;
+	const unsigned char b[] = {
+		(unsigned char)c, (unsigned char)(c >> 8U),
+		(unsigned char)(c >> 16U), (unsigned char)(c >> 24U),
+	};
+
+	wr_put(w, b, sizeof(b));
+	return;
+}
+
+static size_t
+vbyte(unsigned char *buf, uint_fast64_t x)
+{
+/* HDT's variable byte encoding, 7 bits a byte, least significant
+ * first, the last byte has the high bit set */
+	size_t i = 0U;
+
+	for (; x > 127U; x >>= 7U) {
+		buf[i++] = (unsigned char)(x & 127U);
+	}
+	buf[i++] = (unsigned char)(x | 0x80U);
+	return i;
+}
+
+static void
+wr_vbyte(struct wr_s *w, uint_fast64_t x)
+{
+	unsigned char b[10U];
+
+	wr_put(w, b, vbyte(b, x));
+	return;
+}
+
+static void
+wr_ci(struct wr_s *w, unsigned int typ, const char *fmt, const char *prop)
+{
+/* control information, introduces every section */
+	const uint8_t t = (uint8_t)typ;
+
+	wr_beg(w);
+	wr_put(w, "$HDT", 4U);
+	wr_put(w, &t, sizeof(t));
+	wr_put(w, fmt, strlen(fmt) + 1U);
+	wr_put(w, prop, strlen(prop) + 1U);
+	wr_crc16(w);
+	return;
+}
+
+static unsigned int
+nbits(uint_fast64_t x)
+{
+	return x ? 64U - (unsigned int)__builtin_clzll(x) : 1U;
+}
+
+/* bit packer for log arrays and bitmaps, little endian 64-bit words
+ * cut off after the last byte in use */
+struct pk_s {
+	struct wr_s *w;
+	unsigned int nb;
+	unsigned int nacc;
+	uint64_t acc;
+};
+
+static void
+pk_word(struct pk_s *p, unsigned int nbytes)
+{
+	unsigned char b[8U];
+
+	for (unsigned int i = 0U; i < nbytes; i++) {
+		b[i] = (unsigned char)(p->acc >> (8U * i));
+	}
+	wr_put(p->w, b, nbytes);
+	return;
+}
+
+static void
+pk_put(struct pk_s *p, uint_fast64_t x)
+{
+	p->acc |= (uint64_t)x << p->nacc;
+	if ((p->nacc += p->nb) >= 64U) {
+		pk_word(p, 8U);
+		p->nacc -= 64U;
+		/* bits that didn't fit */
+		p->acc = p->nacc ? (uint64_t)x >> (p->nb - p->nacc) : 0U;
+	}
+	return;
+}
+
+static void
+pk_end(struct pk_s *p)
+{
+	if (p->nacc) {
+		pk_word(p, (p->nacc + 7U) / 8U);
+	}
+	/* data checksum */
+	wr_crc32(p->w);
+	return;
+}
+
+static void
+pk_seq(struct pk_s *p, struct wr_s *w, unsigned int nb, size_t n)
+{
+/* start a log array of N entries NB bits wide */
+	const uint8_t typ = 1U, b = (uint8_t)nb;
+
+	wr_beg(w);
+	wr_put(w, &typ, sizeof(typ));
+	wr_put(w, &b, sizeof(b));
+	wr_vbyte(w, n);
+	wr_crc8(w);
+	wr_beg(w);
+	*p = (struct pk_s){.w = w, .nb = nb};
+	return;
+}
+
+static void
+pk_bmp(struct pk_s *p, struct wr_s *w, size_t n)
+{
+/* start a plain bitmap of N bits */
+	const uint8_t typ = 1U;
+
+	wr_beg(w);
+	wr_put(w, &typ, sizeof(typ));
+	wr_vbyte(w, n);
+	wr_crc8(w);
+	wr_beg(w);
+	*p = (struct pk_s){.w = w, .nb = 1U};
+	return;
+}
+
+
+/* string tables */
+static inline uint32_t
+str_hash(const char *s, size_t z)
+{
+	uint32_t h = 0x811c9dc5U;
+
+	for (size_t i = 0U; i < z; i++) {
+		h ^= (unsigned char)s[i];
+		h *= 0x01000193U;
+	}
+	return h;
+}
+
+static int
+tab_rehash(struct strtab_s *t)
+{
+	const size_t nu = t->zidx ? 2U * t->zidx : 1024U;
+	uint32_t *idx;
+
+	if (UNLIKELY((idx = calloc(nu, sizeof(*idx))) == NULL)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < t->nt; i++) {
+		size_t k = t->t[i].hash & (nu - 1U);
+
+		for (; idx[k]; k = (k + 1U) & (nu - 1U));
+		idx[k] = (uint32_t)(i + 1U);
+	}
+	free(t->idx);
+	t->idx = idx;
+	t->zidx = nu;
+	return 0;
+}
+
+static ssize_t
+tab_put(struct strtab_s *t, const char *s, size_t z, unsigned int role)
+{
+/* return the index of S of length Z in T, adding it if need be */
+	const uint32_t h = str_hash(s, z);
+	size_t k;
+
+	if (UNLIKELY(2U * t->nt >= t->zidx) && tab_rehash(t) < 0) {
+		return -1;
+	}
+	for (k = h & (t->zidx - 1U); t->idx[k];
+	     k = (k + 1U) & (t->zidx - 1U)) {
+		struct term_s *x = t->t + t->idx[k] - 1U;
+
+		if (x->hash == h && x->len == z &&
+		    !memcmp(t->heap + x->off, s, z)) {
+			x->role |= role;
+			return t->idx[k] - 1U;
+		}
+	}
+	/* new one */
+	if (UNLIKELY(t->nt >= t->zt) || UNLIKELY(t->hix + z > t->hsz)) {
+		const size_t nzt = t->nt < t->zt ? t->zt : 2U * t->zt ?: 1024U;
+		size_t nhz = t->hsz ?: 65536U;
+		struct term_s *nt;
+		char *nh;
+
+		for (; nhz < t->hix + z; nhz *= 2U);
+		if (UNLIKELY((nt = realloc(t->t, nzt * sizeof(*nt))) == NULL)) {
+			return -1;
+		}
+		t->t = nt;
+		t->zt = nzt;
+		if (UNLIKELY((nh = realloc(t->heap, nhz)) == NULL)) {
+			return -1;
+		}
+		t->heap = nh;
+		t->hsz = nhz;
+	}
+	memcpy(t->heap + t->hix, s, z);
+	t->t[t->nt] = (struct term_s){
+		.off = t->hix, .len = (uint32_t)z, .hash = h, .role = role
+	};
+	t->hix += z;
+	t->idx[k] = (uint32_t)++t->nt;
+	return t->nt - 1U;
+}
+
+static void
+tab_free(struct strtab_s *t)
+{
+	free(t->t);
+	free(t->idx);
+	free(t->heap);
+	return;
+}
+
+/* for the comparison routines, qsort() has no closure */
+static const struct strtab_s *cmp_tab;
+
+static int
+term_cmp(const void *x, const void *y)
+{
+/* byte-wise order, as required for the dictionary */
+	const struct term_s *a = cmp_tab->t + *(const uint32_t*)x;
+	const struct term_s *b = cmp_tab->t + *(const uint32_t*)y;
+	const size_t z = a->len < b->len ? a->len : b->len;
+	const int c = memcmp(cmp_tab->heap + a->off, cmp_tab->heap + b->off, z);
+
+	return c ?: (a->len > b->len) - (a->len < b->len);
+}
+
+static int
+trip_cmp(const void *x, const void *y)
+{
+	const uint32_t *a = x, *b = y;
+
+	for (size_t i = 0U; i < 3U; i++) {
+		if (a[i] != b[i]) {
+			return (a[i] > b[i]) - (a[i] < b[i]);
+		}
+	}
+	return 0;
+}
+
+static void
+tab_sort(const struct strtab_s *t, uint32_t *ord, size_t n)
+{
+	cmp_tab = t;
+	qsort(ord, n, sizeof(*ord), term_cmp);
+	return;
+}
+
+
+/* dictionary sections, plain front coding */
+static int
+wr_pfc(struct wr_s *w, const struct strtab_s *t, const uint32_t *ord, size_t n)
+{
+	const size_t nblk = (n + PFC_BLKZ - 1U) / PFC_BLKZ;
+	size_t *blk;
+	unsigned char *txt = NULL;
+	size_t tix = 0U, tsz = 0U;
+	unsigned char b[32U];
+	struct pk_s p;
+	const char *prev = NULL;
+	size_t prez = 0U;
+
+	if (UNLIKELY((blk = malloc((nblk + 1U) * sizeof(*blk))) == NULL)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < n; i++) {
+		const struct term_s *x = t->t + ord[i];
+		const char *s = t->heap + x->off;
+		size_t c = 0U, z;
+
+		if (i % PFC_BLKZ == 0U) {
+			blk[i / PFC_BLKZ] = tix;
+		} else {
+			/* common prefix with the previous string */
+			for (; c < prez && c < x->len && s[c] == prev[c]; c++);
+		}
+		z = x->len - c + 11U;
+		if (UNLIKELY(tix + z > tsz)) {
+			unsigned char *nu;
+
+			for (tsz = tsz ?: 65536U; tsz < tix + z; tsz *= 2U);
+			if (UNLIKELY((nu = realloc(txt, tsz)) == NULL)) {
+				free(txt);
+				free(blk);
+				return -1;
+			}
+			txt = nu;
+		}
+		if (i % PFC_BLKZ) {
+			tix += vbyte(txt + tix, c);
+		}
+		memcpy(txt + tix, s + c, x->len - c);
+		tix += x->len - c;
+		txt[tix++] = '\0';
+		prev = s;
+		prez = x->len;
+	}
+	blk[nblk] = tix;
+
+	/* section preamble */
+	wr_beg(w);
+	b[0U] = 2U;
+	wr_put(w, b, 1U);
+	wr_vbyte(w, n);
+	wr_vbyte(w, tix);
+	wr_vbyte(w, PFC_BLKZ);
+	wr_crc8(w);
+	/* block offsets */
+	pk_seq(&p, w, nbits(tix), nblk + 1U);
+	for (size_t i = 0U; i <= nblk; i++) {
+		pk_put(&p, blk[i]);
+	}
+	pk_end(&p);
+	/* and the strings */
+	wr_beg(w);
+	wr_put(w, txt, tix);
+	wr_crc32(w);
+
+	free(txt);
+	free(blk);
+	return 0;
+}
+
+
+/* public API */
+hdt_t
+make_hdt(void)
+{
+	crc_init();
+	return calloc(1U, sizeof(struct hdt_s));
+}
+
+void
+free_hdt(hdt_t h)
+{
+	tab_free(&h->so);
+	tab_free(&h->pr);
+	free(h->tr);
+	free(h);
+	return;
+}
+
+int
+hdt_add(hdt_t h,
+	const char *s, size_t sz,
+	const char *p, size_t pz,
+	const char *o, size_t oz)
+{
+	ssize_t si, pi, oi;
+
+	if (UNLIKELY(h->ntr >= h->ztr)) {
+		const size_t nu = h->ztr ? 2U * h->ztr : 65536U;
+		uint32_t (*tr)[3U];
+
+		if (UNLIKELY((tr = realloc(h->tr, nu * sizeof(*tr))) == NULL)) {
+			return -1;
+		}
+		h->tr = tr;
+		h->ztr = nu;
+	}
+	if (UNLIKELY((si = tab_put(&h->so, s, sz, ROLE_S)) < 0) ||
+	    UNLIKELY((pi = tab_put(&h->pr, p, pz, 0U)) < 0) ||
+	    UNLIKELY((oi = tab_put(&h->so, o, oz, ROLE_O)) < 0)) {
+		return -1;
+	}
+	h->tr[h->ntr][0U] = (uint32_t)si;
+	h->tr[h->ntr][1U] = (uint32_t)pi;
+	h->tr[h->ntr][2U] = (uint32_t)oi;
+	h->ntr++;
+	return 0;
+}
+
+int
+hdt_write(hdt_t h, int fd, const char *base)
+{
+	struct wr_s *w;
+	uint32_t *ord = NULL;
+	size_t nsh = 0U, nsu = 0U, nob = 0U, npr = h->pr.nt;
+	size_t ny = 0U, ntr = 0U;
+	uint32_t maxp = 0U, maxo = 0U;
+	size_t sizs = 0U;
+	char *hdr = NULL;
+	size_t hdz = 0U;
+	char prop[256U];
+	int rc = -1;
+
+	if (UNLIKELY((w = malloc(sizeof(*w))) == NULL)) {
+		return -1;
+	}
+	w->fd = fd;
+	w->rc = 0;
+	w->n = 0U;
+	if (UNLIKELY((ord = malloc((h->so.nt + npr) * sizeof(*ord))) == NULL)) {
+		goto out;
+	}
+
+	/* sections: shared, subjects, objects, then predicates */
+	for (size_t i = 0U; i < h->so.nt; i++) {
+		nsh += h->so.t[i].role == (ROLE_S | ROLE_O);
+		nsu += h->so.t[i].role == ROLE_S;
+	}
+	nob = h->so.nt - nsh - nsu;
+	{
+		size_t ksh = 0U, ksu = nsh, kob = nsh + nsu;
+
+		for (size_t i = 0U; i < h->so.nt; i++) {
+			switch (h->so.t[i].role) {
+			case ROLE_S | ROLE_O:
+				ord[ksh++] = (uint32_t)i;
+				break;
+			case ROLE_S:
+				ord[ksu++] = (uint32_t)i;
+				break;
+			default:
+				ord[kob++] = (uint32_t)i;
+				break;
+			}
+		}
+	}
+	for (size_t i = 0U; i < npr; i++) {
+		ord[h->so.nt + i] = (uint32_t)i;
+	}
+	tab_sort(&h->so, ord, nsh);
+	tab_sort(&h->so, ord + nsh, nsu);
+	tab_sort(&h->so, ord + nsh + nsu, nob);
+	tab_sort(&h->pr, ord + h->so.nt, npr);
+	/* subjects and objects are numbered after the shared ones */
+	for (size_t i = 0U; i < nsh + nsu; i++) {
+		h->so.t[ord[i]].id = (uint32_t)(i + 1U);
+	}
+	for (size_t i = 0U; i < nob; i++) {
+		h->so.t[ord[nsh + nsu + i]].id = (uint32_t)(nsh + i + 1U);
+	}
+	for (size_t i = 0U; i < npr; i++) {
+		h->pr.t[ord[h->so.nt + i]].id = (uint32_t)(i + 1U);
+	}
+	sizs = h->so.hix + h->pr.hix;
+
+	/* triples in SPO order, without duplicates */
+	for (size_t i = 0U; i < h->ntr; i++) {
+		h->tr[i][0U] = h->so.t[h->tr[i][0U]].id;
+		h->tr[i][1U] = h->pr.t[h->tr[i][1U]].id;
+		h->tr[i][2U] = h->so.t[h->tr[i][2U]].id;
+	}
+	qsort(h->tr, h->ntr, sizeof(*h->tr), trip_cmp);
+	for (size_t i = 0U; i < h->ntr; i++) {
+		if (ntr && !trip_cmp(h->tr[ntr - 1U], h->tr[i])) {
+			continue;
+		}
+		if (!ntr || h->tr[ntr - 1U][0U] != h->tr[i][0U] ||
+		    h->tr[ntr - 1U][1U] != h->tr[i][1U]) {
+			ny++;
+		}
+		if (h->tr[i][1U] > maxp) {
+			maxp = h->tr[i][1U];
+		}
+		if (h->tr[i][2U] > maxo) {
+			maxo = h->tr[i][2U];
+		}
+		memmove(h->tr[ntr++], h->tr[i], sizeof(*h->tr));
+	}
+	h->ntr = ntr;
+
+	/* global control information */
+	wr_ci(w, CI_GLOBAL, HDT_V1, "");
+
+	/* header, as n-triples */
+	{
+		FILE *f;
+
+		if (UNLIKELY((f = open_memstream(&hdr, &hdz)) == NULL)) {
+			goto out;
+		}
+		fprintf(f, "\
+<%s> <http://www.w3.org/1999/02/22-rdf-syntax-ns#type> <" HDT_NS "Dataset> .\n\
+<%s> <http://www.w3.org/1999/02/22-rdf-syntax-ns#type> <http://rdfs.org/ns/void#Dataset> .\n\
+<%s> <http://rdfs.org/ns/void#triples> \"%zu\" .\n\
+<%s> <http://rdfs.org/ns/void#properties> \"%zu\" .\n\
+<%s> <http://rdfs.org/ns/void#distinctSubjects> \"%zu\" .\n\
+<%s> <http://rdfs.org/ns/void#distinctObjects> \"%zu\" .\n\
+<%s> <" HDT_NS "formatInformation> _:format .\n\
+_:format <" HDT_NS "dictionary> _:dictionary .\n\
+_:format <" HDT_NS "triples> _:triples .\n\
+_:dictionary <http://purl.org/dc/terms/format> " HDT_FOUR " .\n\
+_:dictionary <" HDT_NS "dictionarynumSharedSubjectObject> \"%zu\" .\n\
+_:dictionary <" HDT_NS "dictionarysizeStrings> \"%zu\" .\n\
+_:triples <http://purl.org/dc/terms/format> " HDT_BITMAP " .\n\
+_:triples <" HDT_NS "triplesnumTriples> \"%zu\" .\n\
+_:triples <" HDT_NS "triplesOrder> \"SPO\" .\n",
+			base, base, base, ntr, base, npr,
+			base, nsh + nsu, base, nsh + nob, base,
+			nsh, sizs, ntr);
+		fclose(f);
+	}
+	snprintf(prop, sizeof(prop), "length=%zu;", hdz);
+	wr_ci(w, CI_HEADER, "ntriples", prop);
+	wr_put(w, hdr, hdz);
+
+	/* dictionary */
+	snprintf(prop, sizeof(prop), "elements=%zu;mapping=2;sizeStrings=%zu;",
+		 h->so.nt + npr, sizs);
+	wr_ci(w, CI_DICT, HDT_FOUR, prop);
+	if (wr_pfc(w, &h->so, ord, nsh) < 0 ||
+	    wr_pfc(w, &h->so, ord + nsh, nsu) < 0 ||
+	    wr_pfc(w, &h->pr, ord + h->so.nt, npr) < 0 ||
+	    wr_pfc(w, &h->so, ord + nsh + nsu, nob) < 0) {
+		goto out;
+	}
+
+	/* triples */
+	snprintf(prop, sizeof(prop), "numTriples=%zu;order=1;", ntr);
+	wr_ci(w, CI_TRIPLES, HDT_BITMAP, prop);
+	{
+		struct pk_s p;
+
+		/* Y bits mark the last predicate of a subject */
+		pk_bmp(&p, w, ny);
+		for (size_t i = 0U; i < ntr; i++) {
+			if (i + 1U < ntr &&
+			    h->tr[i + 1U][0U] == h->tr[i][0U] &&
+			    h->tr[i + 1U][1U] == h->tr[i][1U]) {
+				continue;
+			}
+			pk_put(&p, i + 1U >= ntr ||
+			       h->tr[i + 1U][0U] != h->tr[i][0U]);
+		}
+		pk_end(&p);
+
+		/* Z bits mark the last object of a subject-predicate pair */
+		pk_bmp(&p, w, ntr);
+		for (size_t i = 0U; i < ntr; i++) {
+			pk_put(&p, i + 1U >= ntr ||
+			       h->tr[i + 1U][0U] != h->tr[i][0U] ||
+			       h->tr[i + 1U][1U] != h->tr[i][1U]);
+		}
+		pk_end(&p);
+
+		/* predicates */
+		pk_seq(&p, w, nbits(maxp), ny);
+		for (size_t i = 0U; i < ntr; i++) {
+			if (i + 1U < ntr &&
+			    h->tr[i + 1U][0U] == h->tr[i][0U] &&
+			    h->tr[i + 1U][1U] == h->tr[i][1U]) {
+				continue;
+			}
+			pk_put(&p, h->tr[i][1U]);
+		}
+		pk_end(&p);
+
+		/* objects */
+		pk_seq(&p, w, nbits(maxo), ntr);
+		for (size_t i = 0U; i < ntr; i++) {
+			pk_put(&p, h->tr[i][2U]);
+		}
+		pk_end(&p);
+	}
+	wr_flush(w);
+	rc = w->rc;
+
+out:
+	free(hdr);
+	free(ord);
+	free(w);
+	return rc;
+}
+
+/* hdt.c ends here */
@@ -0,0 +1,72 @@
+/*** hdt.h -- HDT writer
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if !defined INCLUDED_hdt_h_
+#define INCLUDED_hdt_h_
+
+#include <stddef.h>
+
+typedef struct hdt_s *hdt_t;
+
+/**
+ * Return a new and empty collection of triples. */
+extern hdt_t make_hdt(void);
+
+/**
+ * Free resources associated with H. */
+extern void free_hdt(hdt_t h);
+
+/**
+ * Add the triple S P O to H, with terms in the notation of HDT's
+ * dictionary, i.e. IRIs without angle brackets and literals in double
+ * quotes, optionally followed by @LANG or ^^<TYPE>, nothing escaped.
+ * Terms must not contain \0.
+ * H must not be used from several threads at the same time.
+ * Return 0 on success, -1 if out of memory. */
+extern int
+hdt_add(hdt_t h,
+	const char *s, size_t sz,
+	const char *p, size_t pz,
+	const char *o, size_t oz);
+
+/**
+ * Write H's triples as HDT file (four-section dictionary, bitmap
+ * triples) to FD, describing the data set as BASE in the header.
+ * Duplicate triples are written once.
+ * Return 0 on success, -1 otherwise. */
+extern int hdt_write(hdt_t h, int fd, const char *base);
+
+#endif	/* INCLUDED_hdt_h_ */
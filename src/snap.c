@@ -0,0 +1,790 @@
+/*** snap.c -- compact memory-mappable LEI snapshots
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+/* A snapshot is a table of string columns, rows ordered by the first
+ * column, the key.  All numbers are in host byte order, sections start
+ * at multiples of 8:
+ *
+ *   header      magic, version, #columns, #rows, file size
+ *   directory   per column: offsets of its name, codes, value offsets
+ *               and value heap, the heap's size, #values, code width
+ *   columns     plain: #rows + 1 uint32 offsets into the heap
+ *               dictionary-coded: #rows uint16 or uint32 codes, value
+ *               id plus 1 or 0 if absent, #values + 1 offsets, heap,
+ *               values in ascending order
+ *   names       \0-terminated
+ *
+ * Empty values denote absent ones. */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snap.h"
+
+#if !defined LIKELY
+# define LIKELY(_x)	__builtin_expect((_x), 1)
+#endif
+#if !defined UNLIKELY
+# define UNLIKELY(_x)	__builtin_expect((_x), 0)
+#endif
+
+#define SNAP_VER	(1U)
+/* initial number of dictionary slots, a power of 2 */
+#define DICT_INI	(256U)
+/* size of the write buffer */
+#define WBUFZ		(65536U)
+
+#define DICTP(_m, _i)	((_m) >> (_i) & 1U)
+#define ALIGN8(_x)	(((_x) + 7U) & ~(uint64_t)7U)
+
+static const char snap_magic[8U] = {'G', 'L', 'E', 'I', 'S', 'N', 'A', 'P'};
+
+struct shdr_s {
+	char magic[8U];
+	uint32_t ver;
+	uint32_t ncol;
+	uint64_t nrow;
+	uint64_t size;
+};
+
+struct scol_s {
+	/* file offsets */
+	uint64_t name;
+	uint64_t code;
+	uint64_t voff;
+	uint64_t heap;
+	uint64_t heapz;
+	uint32_t nval;
+	/* bytes per code, 0 for plain columns */
+	uint32_t width;
+};
+
+struct dict_s {
+	/* values back to back and their offsets, N + 1 of them */
+	char *dat;
+	size_t ndat;
+	size_t zdat;
+	uint32_t *off;
+	size_t n;
+	size_t zoff;
+	/* open addressing, slots hold value ids plus 1 */
+	uint32_t *slot;
+	size_t nslot;
+};
+
+struct col_s {
+	/* plain columns: value offsets, N + 1 of them, and values */
+	uint32_t *off;
+	size_t zoff;
+	char *dat;
+	size_t ndat;
+	size_t zdat;
+	/* dictionary-coded columns: value ids plus 1, 0 if absent */
+	uint32_t *code;
+	size_t zcode;
+	struct dict_s *dict;
+};
+
+struct snap_s {
+	const char *const *names;
+	size_t n;
+	size_t ncol;
+	struct col_s col[];
+};
+
+struct smap_s {
+	char *buf;
+	size_t len;
+	size_t nrow;
+	size_t ncol;
+	const struct scol_s *col;
+};
+
+
+static int
+grow(void *ptr, size_t *z, size_t need, size_t elz)
+{
+/* make *PTR, an array of *Z elements of size ELZ, hold at least NEED
+ * elements, new elements are zeroed */
+	void **p = ptr;
+	size_t nz = *z ? *z : 64U;
+	void *np;
+
+	if (LIKELY(need <= *z)) {
+		return 0;
+	}
+	for (; nz < need; nz *= 2U);
+	if (UNLIKELY((np = realloc(*p, nz * elz)) == NULL)) {
+		return -1;
+	}
+	memset((char*)np + *z * elz, 0, (nz - *z) * elz);
+	*p = np;
+	*z = nz;
+	return 0;
+}
+
+static uint32_t
+str_hash(const char *s, size_t z)
+{
+	uint32_t h = 0x811c9dc5U;
+
+	for (size_t i = 0U; i < z; i++) {
+		h ^= (unsigned char)s[i];
+		h *= 0x01000193U;
+	}
+	return h;
+}
+
+static int
+key_cmp(const char *s, size_t sz, const char *t, size_t tz)
+{
+	int c = memcmp(s, t, sz < tz ? sz : tz);
+
+	return c ?: (sz > tz) - (sz < tz);
+}
+
+
+/* dictionaries */
+static struct dict_s*
+make_dict(void)
+{
+	struct dict_s *d = calloc(1U, sizeof(*d));
+
+	if (UNLIKELY(d == NULL)) {
+		return NULL;
+	}
+	if (UNLIKELY(grow(&d->off, &d->zoff, 1U, sizeof(*d->off)) < 0)) {
+		free(d);
+		return NULL;
+	}
+	return d;
+}
+
+static void
+free_dict(struct dict_s *d)
+{
+	if (d == NULL) {
+		return;
+	}
+	free(d->dat);
+	free(d->off);
+	free(d->slot);
+	free(d);
+	return;
+}
+
+static int
+dict_rehash(struct dict_s *d)
+{
+	const size_t nz = d->nslot ? 2U * d->nslot : DICT_INI;
+	uint32_t *ns = calloc(nz, sizeof(*ns));
+
+	if (UNLIKELY(ns == NULL)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < d->n; i++) {
+		const char *s = d->dat + d->off[i];
+		const size_t z = d->off[i + 1U] - d->off[i];
+		size_t k = str_hash(s, z) & (nz - 1U);
+
+		for (; ns[k]; k = (k + 1U) & (nz - 1U));
+		ns[k] = (uint32_t)(i + 1U);
+	}
+	free(d->slot);
+	d->slot = ns;
+	d->nslot = nz;
+	return 0;
+}
+
+static uint32_t
+dict_code(struct dict_s *d, const char *s, size_t z)
+{
+/* return the id of S in D plus 1, adding it if need be, or 0 */
+	size_t k;
+
+	if (UNLIKELY(2U * (d->n + 1U) > d->nslot && dict_rehash(d) < 0)) {
+		return 0U;
+	}
+	for (k = str_hash(s, z) & (d->nslot - 1U); d->slot[k];
+	     k = (k + 1U) & (d->nslot - 1U)) {
+		const size_t i = d->slot[k] - 1U;
+
+		if (d->off[i + 1U] - d->off[i] == z &&
+		    !memcmp(d->dat + d->off[i], s, z)) {
+			return (uint32_t)(i + 1U);
+		}
+	}
+	/* new value */
+	if (UNLIKELY(d->ndat + z > UINT32_MAX ||
+		     grow(&d->dat, &d->zdat, d->ndat + z, 1U) < 0 ||
+		     grow(&d->off, &d->zoff, d->n + 2U, sizeof(*d->off)) < 0)) {
+		return 0U;
+	}
+	memcpy(d->dat + d->ndat, s, z);
+	d->ndat += z;
+	d->off[++d->n] = (uint32_t)d->ndat;
+	d->slot[k] = (uint32_t)d->n;
+	return (uint32_t)d->n;
+}
+
+
+/* writing */
+struct swr_s {
+	int fd;
+	int rc;
+	size_t n;
+	char b[WBUFZ];
+};
+
+static void
+sw_flush(struct swr_s *w)
+{
+	for (const char *bp = w->b; w->n > 0U && !w->rc;) {
+		ssize_t nwr = write(w->fd, bp, w->n);
+
+		if (UNLIKELY(nwr < 0)) {
+			if (errno == EINTR) {
+				continue;
+			}
+			w->rc = -1;
+			break;
+		}
+		bp += nwr;
+		w->n -= nwr;
+	}
+	w->n = 0U;
+	return;
+}
+
+static void
+sw_put(struct swr_s *w, const void *p, size_t z)
+{
+/* buffer Z bytes of P, or zeroes if P is NULL */
+	for (const char *bp = p; z > 0U;) {
+		const size_t n = z < WBUFZ - w->n ? z : WBUFZ - w->n;
+
+		if (bp != NULL) {
+			memcpy(w->b + w->n, bp, n);
+			bp += n;
+		} else {
+			memset(w->b + w->n, 0, n);
+		}
+		w->n += n;
+		z -= n;
+		if (w->n >= WBUFZ) {
+			sw_flush(w);
+		}
+	}
+	return;
+}
+
+static void
+sw_pad(struct swr_s *w, uint64_t z)
+{
+/* pad a section of Z bytes to a multiple of 8 */
+	sw_put(w, NULL, ALIGN8(z) - z);
+	return;
+}
+
+struct key_s {
+	const char *s;
+	size_t z;
+	size_t row;
+};
+
+static int
+key_ord(const void *x, const void *y)
+{
+	const struct key_s *a = x;
+	const struct key_s *b = y;
+
+	/* rows with equal keys stay in the order they were added */
+	return key_cmp(a->s, a->z, b->s, b->z) ?:
+		(a->row > b->row) - (a->row < b->row);
+}
+
+static void
+sw_vals(struct swr_s *w, const struct key_s *v, size_t n)
+{
+/* write offsets and heap of the N values V */
+	uint64_t z = 0U;
+
+	for (size_t i = 0U; i <= n; i++) {
+		const uint32_t o = (uint32_t)z;
+
+		sw_put(w, &o, sizeof(o));
+		z += i < n ? v[i].z : 0U;
+	}
+	sw_pad(w, (n + 1U) * sizeof(uint32_t));
+	for (size_t i = 0U; i < n; i++) {
+		sw_put(w, v[i].s, v[i].z);
+	}
+	sw_pad(w, z);
+	return;
+}
+
+static const char*
+col_val(const struct col_s *c, size_t row, size_t *z)
+{
+	if (c->dict != NULL) {
+		const uint32_t k = c->code[row];
+
+		if (!k) {
+			*z = 0U;
+			return "";
+		}
+		*z = c->dict->off[k] - c->dict->off[k - 1U];
+		return c->dict->dat + c->dict->off[k - 1U];
+	}
+	if (!(*z = c->off[row + 1U] - c->off[row])) {
+		return "";
+	}
+	return c->dat + c->off[row];
+}
+
+
+/* public API */
+int
+snap_magicp(const char *buf, size_t len)
+{
+	return len >= sizeof(struct shdr_s) &&
+		!memcmp(buf, snap_magic, sizeof(snap_magic));
+}
+
+snap_t
+make_snap(const char *const *names, size_t ncol, uint64_t dict)
+{
+	struct snap_s *s;
+
+	if (UNLIKELY(!ncol || ncol > UINT32_MAX)) {
+		return NULL;
+	} else if (UNLIKELY((s = calloc(1U, sizeof(*s) +
+					ncol * sizeof(*s->col))) == NULL)) {
+		return NULL;
+	}
+	s->names = names;
+	s->ncol = ncol;
+	for (size_t i = 0U; i < ncol; i++) {
+		if (DICTP(dict, i) &&
+		    UNLIKELY((s->col[i].dict = make_dict()) == NULL)) {
+			free_snap(s);
+			return NULL;
+		}
+	}
+	return s;
+}
+
+void
+free_snap(snap_t s)
+{
+	for (size_t i = 0U; i < s->ncol; i++) {
+		free(s->col[i].off);
+		free(s->col[i].dat);
+		free(s->col[i].code);
+		free_dict(s->col[i].dict);
+	}
+	free(s);
+	return;
+}
+
+ssize_t
+snap_add(snap_t s, const char *const *v, const size_t *z)
+{
+	const size_t n = s->n;
+
+	if (UNLIKELY(n >= UINT32_MAX - 1U)) {
+		return -1;
+	}
+	for (size_t i = 0U; i < s->ncol; i++) {
+		struct col_s *c = s->col + i;
+		const size_t len = v[i] != NULL ? z[i] : 0U;
+
+		if (c->dict != NULL) {
+			uint32_t k = 0U;
+
+			if (UNLIKELY(grow(&c->code, &c->zcode, n + 1U,
+					  sizeof(*c->code)) < 0)) {
+				goto undo;
+			} else if (len && UNLIKELY(!(k = dict_code(c->dict,
+							      v[i], len)))) {
+				goto undo;
+			}
+			c->code[n] = k;
+		} else if (UNLIKELY(c->ndat + len > UINT32_MAX ||
+				    grow(&c->off, &c->zoff, n + 2U,
+					 sizeof(*c->off)) < 0 ||
+				    grow(&c->dat, &c->zdat,
+					 c->ndat + len, 1U) < 0)) {
+			goto undo;
+		} else {
+			if (len) {
+				memcpy(c->dat + c->ndat, v[i], len);
+			}
+			c->ndat += len;
+			c->off[n + 1U] = (uint32_t)c->ndat;
+		}
+		continue;
+
+	undo:
+		/* forget the columns done so far */
+		for (size_t j = 0U; j < i; j++) {
+			c = s->col + j;
+			if (c->dict == NULL) {
+				c->ndat = c->off[n];
+			}
+		}
+		return -1;
+	}
+	return (ssize_t)++s->n;
+}
+
+int
+snap_write(snap_t s, int fd)
+{
+	struct shdr_s h = {.ver = SNAP_VER, .ncol = (uint32_t)s->ncol};
+	struct scol_s *dir;
+	struct key_s *ord, *val;
+	uint32_t *rank = NULL;
+	struct swr_s *w;
+	size_t nval = s->n;
+	uint64_t pos;
+	int rc = -1;
+
+	for (size_t i = 0U; i < s->ncol; i++) {
+		if (s->col[i].dict != NULL && s->col[i].dict->n > nval) {
+			nval = s->col[i].dict->n;
+		}
+	}
+	dir = calloc(s->ncol, sizeof(*dir));
+	ord = calloc(s->n + 1U, sizeof(*ord));
+	val = calloc(nval + 1U, sizeof(*val));
+	rank = calloc(nval + 1U, sizeof(*rank));
+	w = malloc(sizeof(*w));
+	if (UNLIKELY(dir == NULL || ord == NULL || val == NULL ||
+		     rank == NULL || w == NULL)) {
+		goto fre;
+	}
+	/* order rows by key */
+	for (size_t i = 0U; i < s->n; i++) {
+		ord[i].s = col_val(s->col, i, &ord[i].z);
+		ord[i].row = i;
+	}
+	qsort(ord, s->n, sizeof(*ord), key_ord);
+
+	/* lay out the file */
+	pos = sizeof(h) + s->ncol * sizeof(*dir);
+	for (size_t i = 0U; i < s->ncol; i++) {
+		const struct col_s *c = s->col + i;
+
+		if (c->dict != NULL) {
+			dir[i].width = c->dict->n < 0xffffU ? 2U : 4U;
+			dir[i].code = pos;
+			pos = ALIGN8(pos + s->n * dir[i].width);
+			dir[i].nval = (uint32_t)c->dict->n;
+			dir[i].heapz = c->dict->ndat;
+		} else {
+			dir[i].nval = (uint32_t)s->n;
+			dir[i].heapz = c->ndat;
+		}
+		dir[i].voff = pos;
+		pos = ALIGN8(pos + (dir[i].nval + 1ULL) * sizeof(uint32_t));
+		dir[i].heap = pos;
+		pos = ALIGN8(pos + dir[i].heapz);
+	}
+	for (size_t i = 0U; i < s->ncol; i++) {
+		dir[i].name = pos;
+		pos += strlen(s->names[i]) + 1U;
+	}
+	memcpy(h.magic, snap_magic, sizeof(h.magic));
+	h.nrow = s->n;
+	h.size = ALIGN8(pos);
+
+	w->fd = fd;
+	w->rc = 0;
+	w->n = 0U;
+	sw_put(w, &h, sizeof(h));
+	sw_put(w, dir, s->ncol * sizeof(*dir));
+	for (size_t i = 0U; i < s->ncol; i++) {
+		const struct col_s *c = s->col + i;
+		const struct dict_s *d = c->dict;
+
+		if (d == NULL) {
+			/* values in row order */
+			for (size_t j = 0U; j < s->n; j++) {
+				val[j].s = col_val(c, ord[j].row, &val[j].z);
+			}
+			sw_vals(w, val, s->n);
+			continue;
+		}
+		/* dictionaries in value order, so that equal input makes
+		 * equal snapshots no matter the order rows came in */
+		for (size_t k = 0U; k < d->n; k++) {
+			val[k].s = d->dat + d->off[k];
+			val[k].z = d->off[k + 1U] - d->off[k];
+			val[k].row = k;
+		}
+		qsort(val, d->n, sizeof(*val), key_ord);
+		for (size_t k = 0U; k < d->n; k++) {
+			rank[val[k].row + 1U] = (uint32_t)(k + 1U);
+		}
+		for (size_t j = 0U; j < s->n; j++) {
+			const uint32_t k = rank[c->code[ord[j].row]];
+			const uint16_t k16 = (uint16_t)k;
+
+			if (dir[i].width == 2U) {
+				sw_put(w, &k16, sizeof(k16));
+			} else {
+				sw_put(w, &k, sizeof(k));
+			}
+		}
+		sw_pad(w, s->n * dir[i].width);
+		sw_vals(w, val, d->n);
+	}
+	for (size_t i = 0U; i < s->ncol; i++) {
+		sw_put(w, s->names[i], strlen(s->names[i]) + 1U);
+	}
+	sw_put(w, NULL, h.size - pos);
+	sw_flush(w);
+	rc = w->rc;
+
+fre:
+	free(dir);
+	free(ord);
+	free(val);
+	free(rank);
+	free(w);
+	return rc;
+}
+
+/* reading */
+static bool
+smap_okp(const struct smap_s *m, const struct shdr_s *h)
+{
+/* check that everything M's directory points to is within the file */
+	const uint64_t len = m->len;
+
+	if (h->ver != SNAP_VER || h->size != len || !h->ncol) {
+		return false;
+	} else if (h->nrow > len ||
+		   h->ncol > (len - sizeof(*h)) / sizeof(*m->col)) {
+		return false;
+	}
+	for (size_t i = 0U; i < m->ncol; i++) {
+		const struct scol_s *c = m->col + i;
+		const uint64_t nv = c->nval + 1ULL;
+
+		if (c->name >= len ||
+		    !memchr(m->buf + c->name, 0, len - c->name)) {
+			return false;
+		}
+		switch (c->width) {
+		case 0U:
+			if (c->nval != h->nrow) {
+				return false;
+			}
+			break;
+		case 2U:
+		case 4U:
+			if (c->code % 8U || c->code > len ||
+			    h->nrow * c->width > len - c->code) {
+				return false;
+			}
+			break;
+		default:
+			return false;
+		}
+		if (c->voff % 8U || c->voff > len ||
+		    nv * sizeof(uint32_t) > len - c->voff) {
+			return false;
+		} else if (c->heap > len || c->heapz > len - c->heap) {
+			return false;
+		}
+	}
+	/* lookups need a plain key column */
+	return !m->col->width;
+}
+
+smap_t
+smap_open(const char *file)
+{
+	struct smap_s *m;
+	struct shdr_s h;
+	struct stat st;
+	char *buf;
+	int fd;
+
+	if (file == NULL || (fd = open(file, O_RDONLY)) < 0) {
+		return NULL;
+	} else if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+		   (size_t)st.st_size < sizeof(h)) {
+		close(fd);
+		return NULL;
+	} else if (read(fd, &h, sizeof(h)) != (ssize_t)sizeof(h) ||
+		   !snap_magicp((const char*)&h, sizeof(h))) {
+		/* don't bother mapping what isn't ours */
+		close(fd);
+		return NULL;
+	}
+	buf = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (UNLIKELY(buf == MAP_FAILED)) {
+		return NULL;
+	} else if (UNLIKELY((m = malloc(sizeof(*m))) == NULL)) {
+		goto unm;
+	}
+	m->buf = buf;
+	m->len = st.st_size;
+	m->nrow = h.nrow;
+	m->ncol = h.ncol;
+	m->col = (const void*)(m->buf + sizeof(h));
+	if (UNLIKELY(!smap_okp(m, &h))) {
+		free(m);
+		goto unm;
+	}
+	return m;
+
+unm:
+	munmap(buf, st.st_size);
+	return NULL;
+}
+
+void
+smap_close(smap_t m)
+{
+	munmap(m->buf, m->len);
+	free(m);
+	return;
+}
+
+size_t
+smap_nrow(smap_t m)
+{
+	return m->nrow;
+}
+
+size_t
+smap_ncol(smap_t m)
+{
+	return m->ncol;
+}
+
+const char*
+smap_name(smap_t m, size_t col)
+{
+	return m->buf + m->col[col].name;
+}
+
+ssize_t
+smap_col(smap_t m, const char *name)
+{
+	for (size_t i = 0U; i < m->ncol; i++) {
+		if (!strcmp(m->buf + m->col[i].name, name)) {
+			return (ssize_t)i;
+		}
+	}
+	return -1;
+}
+
+const char*
+smap_val(smap_t m, size_t row, size_t col, size_t *len)
+{
+	const struct scol_s *c = m->col + col;
+	const uint32_t *vo;
+	size_t v = row;
+
+	if (UNLIKELY(row >= m->nrow || col >= m->ncol)) {
+		return NULL;
+	}
+	switch (c->width) {
+	case 2U:
+		v = ((const uint16_t*)(m->buf + c->code))[row];
+		goto code;
+	case 4U:
+		v = ((const uint32_t*)(m->buf + c->code))[row];
+	code:
+		if (!v-- || UNLIKELY(v >= c->nval)) {
+			return NULL;
+		}
+		break;
+	default:
+		break;
+	}
+	vo = (const uint32_t*)(m->buf + c->voff);
+	if (vo[v] >= vo[v + 1U] || UNLIKELY(vo[v + 1U] > c->heapz)) {
+		/* empty or bogus */
+		return NULL;
+	}
+	*len = vo[v + 1U] - vo[v];
+	return m->buf + c->heap + vo[v];
+}
+
+ssize_t
+smap_find(smap_t m, const char *key, size_t z)
+{
+	size_t lo = 0U, hi = m->nrow;
+	const char *s;
+	size_t sz;
+
+	/* first row whose key isn't less than KEY */
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2U;
+
+		if ((s = smap_val(m, mid, 0U, &sz)) == NULL) {
+			s = "";
+			sz = 0U;
+		}
+		if (key_cmp(s, sz, key, z) < 0) {
+			lo = mid + 1U;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo >= m->nrow || (s = smap_val(m, lo, 0U, &sz)) == NULL ||
+	    key_cmp(s, sz, key, z)) {
+		return -1;
+	}
+	return (ssize_t)lo;
+}
+
+/* snap.c ends here */
@@ -0,0 +1,110 @@
+/*** snap.h -- compact memory-mappable LEI snapshots
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if !defined INCLUDED_snap_h_
+#define INCLUDED_snap_h_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct snap_s *snap_t;
+typedef struct smap_s *smap_t;
+
+/**
+ * Return non-0 if BUF (of length LEN) starts like a snapshot. */
+extern int snap_magicp(const char *buf, size_t len);
+
+/**
+ * Return a builder for a snapshot of NCOL string columns named NAMES,
+ * the first of which is the key.  Columns whose bit is set in DICT
+ * are dictionary-coded, which pays off for low-cardinality values.
+ * NAMES must stay valid while the builder lives. */
+extern snap_t make_snap(const char *const *names, size_t ncol, uint64_t dict);
+
+/**
+ * Free resources associated with S. */
+extern void free_snap(snap_t s);
+
+/**
+ * Add a row to S, V[i] of length Z[i] being the value of column i or
+ * NULL if absent.  Empty values are treated as absent.
+ * S must not be used from several threads at the same time.
+ * Return the number of rows in S, or -1 on failure. */
+extern ssize_t snap_add(snap_t s, const char *const *v, const size_t *z);
+
+/**
+ * Write S's rows, ordered by key, as snapshot to FD.
+ * Return 0 on success, -1 otherwise. */
+extern int snap_write(snap_t s, int fd);
+
+/**
+ * Map snapshot FILE into memory.
+ * Return NULL if FILE can't be mapped or isn't a snapshot. */
+extern smap_t smap_open(const char *file);
+
+/**
+ * Unmap M and free resources associated with it. */
+extern void smap_close(smap_t m);
+
+/**
+ * Return the number of rows in M. */
+extern size_t smap_nrow(smap_t m);
+
+/**
+ * Return the number of columns in M. */
+extern size_t smap_ncol(smap_t m);
+
+/**
+ * Return the name of column COL of M. */
+extern const char *smap_name(smap_t m, size_t col);
+
+/**
+ * Return the index of the column of M named NAME, or -1. */
+extern ssize_t smap_col(smap_t m, const char *name);
+
+/**
+ * Return the value of column COL in row ROW of M and put its length
+ * into *LEN, or return NULL if the value is absent.
+ * Values point into the mapping and are not \0-terminated. */
+extern const char*
+smap_val(smap_t m, size_t row, size_t col, size_t *len);
+
+/**
+ * Return the first row of M whose key is KEY of length Z, or -1. */
+extern ssize_t smap_find(smap_t m, const char *key, size_t z);
+
+#endif	/* INCLUDED_snap_h_ */
@@ -0,0 +1,499 @@
+/*** unz.c -- in-process decompression of golden copies
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#if defined HAVE_ZLIB
+# include <zlib.h>
+#endif	/* HAVE_ZLIB */
+#if defined HAVE_LZMA
+# include <lzma.h>
+#endif	/* HAVE_LZMA */
+#include "unz.h"
+
+#if !defined LIKELY
+# define LIKELY(_x)	__builtin_expect((_x), 1)
+#endif
+#if !defined UNLIKELY
+# define UNLIKELY(_x)	__builtin_expect((_x), 0)
+#endif
+#define countof(_x)	(sizeof(_x) / sizeof(*_x))
+
+/* size of the blocks handed from the inflater to the reader */
+#define BLKZ	(1U << 20U)
+/* number of blocks in flight */
+#define NBLK	(4U)
+/* size of the raw input buffer */
+#define INZ	(256U * 1024U)
+/* bytes needed to tell the formats apart */
+#define NMAGIC	(6U)
+
+typedef enum {
+	UNZ_NONE,
+	UNZ_GZ,
+	UNZ_ZIP,
+	UNZ_XZ,
+} unz_typ_t;
+
+struct unz_s {
+	int fd;
+	unz_typ_t typ;
+	/* bytes consumed by make_unz() to determine the type */
+	unsigned char pk[NMAGIC];
+	size_t npk;
+	size_t ipk;
+
+	/* inflater thread and its ring of blocks */
+	pthread_t th;
+	pthread_mutex_t mtx;
+	pthread_cond_t cnd;
+	struct {
+		char *buf;
+		size_t len;
+	} blk[NBLK];
+	/* number of blocks produced and consumed */
+	size_t np;
+	size_t nc;
+	/* read offset into the current block */
+	size_t bo;
+	bool eofp;
+	bool stopp;
+	int rc;
+};
+
+
+static unz_typ_t
+unz_typ(const unsigned char *b, size_t z)
+{
+	static const unsigned char gz[] = {0x1fU, 0x8bU};
+	static const unsigned char zip[] = {'P', 'K', 0x03U, 0x04U};
+	static const unsigned char xz[] = {0xfdU, '7', 'z', 'X', 'Z', 0x00U};
+
+	if (z >= sizeof(gz) && !memcmp(b, gz, sizeof(gz))) {
+		return UNZ_GZ;
+	} else if (z >= sizeof(zip) && !memcmp(b, zip, sizeof(zip))) {
+		return UNZ_ZIP;
+	} else if (z >= sizeof(xz) && !memcmp(b, xz, sizeof(xz))) {
+		return UNZ_XZ;
+	}
+	return UNZ_NONE;
+}
+
+static ssize_t
+raw_read(struct unz_s *u, void *buf, size_t len)
+{
+/* read from U's fd, serving the peeked bytes first */
+	ssize_t nrd;
+
+	if (u->ipk < u->npk) {
+		const size_t z = u->npk - u->ipk < len ? u->npk - u->ipk : len;
+
+		memcpy(buf, u->pk + u->ipk, z);
+		u->ipk += z;
+		return z;
+	}
+	while ((nrd = read(u->fd, buf, len)) < 0 && errno == EINTR);
+	return nrd;
+}
+
+static ssize_t
+raw_full(struct unz_s *u, void *buf, size_t len)
+{
+/* like raw_read() but insist on LEN bytes unless at EOF */
+	size_t tot = 0U;
+
+	for (ssize_t nrd; tot < len; tot += nrd) {
+		nrd = raw_read(u, (char*)buf + tot, len - tot);
+		if (nrd < 0) {
+			return -1;
+		} else if (nrd == 0) {
+			break;
+		}
+	}
+	return tot;
+}
+
+
+/* block ring, the inflater thread produces, unz_read() consumes */
+static char*
+blk_get(struct unz_s *u)
+{
+/* return the next free block or NULL if the reader has gone */
+	char *b;
+
+	pthread_mutex_lock(&u->mtx);
+	while (u->np - u->nc >= NBLK && !u->stopp) {
+		pthread_cond_wait(&u->cnd, &u->mtx);
+	}
+	b = !u->stopp ? u->blk[u->np % NBLK].buf : NULL;
+	pthread_mutex_unlock(&u->mtx);
+	return b;
+}
+
+static void
+blk_put(struct unz_s *u, size_t len)
+{
+/* publish the block obtained by blk_get() holding LEN bytes */
+	if (!len) {
+		return;
+	}
+	pthread_mutex_lock(&u->mtx);
+	u->blk[u->np++ % NBLK].len = len;
+	pthread_cond_broadcast(&u->cnd);
+	pthread_mutex_unlock(&u->mtx);
+}
+
+static void
+blk_eof(struct unz_s *u, int rc)
+{
+	pthread_mutex_lock(&u->mtx);
+	u->eofp = true;
+	u->rc = rc;
+	pthread_cond_broadcast(&u->cnd);
+	pthread_mutex_unlock(&u->mtx);
+}
+
+
+static int
+unz_copy(struct unz_s *u, uint_fast64_t len)
+{
+/* copy LEN bytes of stored data */
+	for (char *b; len && (b = blk_get(u)) != NULL;) {
+		const size_t z = len < BLKZ ? len : BLKZ;
+		ssize_t nrd = raw_full(u, b, z);
+
+		if (nrd <= 0) {
+			return -1;
+		}
+		blk_put(u, nrd);
+		len -= nrd;
+	}
+	return 0;
+}
+
+#if defined HAVE_ZLIB
+static int
+unz_zlib(struct unz_s *u, int wbits)
+{
+	unsigned char *in;
+	z_stream z = {NULL};
+	int zrc = Z_OK;
+
+	if (UNLIKELY((in = malloc(INZ)) == NULL)) {
+		return -1;
+	} else if (UNLIKELY(inflateInit2(&z, wbits) != Z_OK)) {
+		free(in);
+		return -1;
+	}
+	for (char *b; zrc == Z_OK && (b = blk_get(u)) != NULL;) {
+		z.next_out = (unsigned char*)b;
+		z.avail_out = BLKZ;
+		while (z.avail_out && zrc == Z_OK) {
+			ssize_t nrd;
+
+			if (!z.avail_in) {
+				if ((nrd = raw_read(u, in, INZ)) <= 0) {
+					/* truncated or read error */
+					zrc = Z_DATA_ERROR;
+					break;
+				}
+				z.next_in = in;
+				z.avail_in = nrd;
+			}
+			zrc = inflate(&z, Z_NO_FLUSH);
+			if (zrc != Z_STREAM_END || u->typ != UNZ_GZ) {
+				continue;
+			} else if (!z.avail_in) {
+				/* see if another gzip member follows */
+				if ((nrd = raw_read(u, in, INZ)) < 0) {
+					zrc = Z_DATA_ERROR;
+					break;
+				} else if (nrd == 0) {
+					break;
+				}
+				z.next_in = in;
+				z.avail_in = nrd;
+			}
+			inflateReset(&z);
+			zrc = Z_OK;
+		}
+		blk_put(u, BLKZ - z.avail_out);
+	}
+	inflateEnd(&z);
+	free(in);
+	return zrc == Z_STREAM_END ? 0 : -1;
+}
+#endif	/* HAVE_ZLIB */
+
+#if defined HAVE_LZMA
+static int
+unz_lzma(struct unz_s *u)
+{
+	lzma_stream l = LZMA_STREAM_INIT;
+	lzma_action act = LZMA_RUN;
+	lzma_ret lrc = LZMA_OK;
+	unsigned char *in;
+
+	if (UNLIKELY((in = malloc(INZ)) == NULL)) {
+		return -1;
+	} else if (lzma_stream_decoder(
+			   &l, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+		free(in);
+		return -1;
+	}
+	for (char *b; lrc == LZMA_OK && (b = blk_get(u)) != NULL;) {
+		l.next_out = (uint8_t*)b;
+		l.avail_out = BLKZ;
+		do {
+			if (!l.avail_in && act == LZMA_RUN) {
+				ssize_t nrd = raw_read(u, in, INZ);
+
+				if (nrd < 0) {
+					lrc = LZMA_DATA_ERROR;
+					break;
+				} else if (nrd == 0) {
+					act = LZMA_FINISH;
+				}
+				l.next_in = in;
+				l.avail_in = nrd;
+			}
+			lrc = lzma_code(&l, act);
+		} while (l.avail_out && lrc == LZMA_OK);
+		blk_put(u, BLKZ - l.avail_out);
+	}
+	lzma_end(&l);
+	free(in);
+	return lrc == LZMA_STREAM_END ? 0 : -1;
+}
+#endif	/* HAVE_LZMA */
+
+static int
+unz_zip(struct unz_s *u)
+{
+/* inflate the first member of a zip archive, golden copies hold
+ * exactly one */
+	unsigned char hdr[30U];
+	unsigned int meth, flags;
+	size_t skip;
+
+	if (raw_full(u, hdr, sizeof(hdr)) < (ssize_t)sizeof(hdr)) {
+		return -1;
+	}
+	flags = hdr[6U] | hdr[7U] << 8U;
+	meth = hdr[8U] | hdr[9U] << 8U;
+	/* skip file name and extra field */
+	skip = (hdr[26U] | hdr[27U] << 8U) + (hdr[28U] | hdr[29U] << 8U);
+	for (unsigned char buf[256U]; skip;) {
+		const size_t z = skip < sizeof(buf) ? skip : sizeof(buf);
+
+		if (raw_full(u, buf, z) < (ssize_t)z) {
+			return -1;
+		}
+		skip -= z;
+	}
+	switch (meth) {
+	case 0U:
+		/* stored, we need to know its size */
+		if (flags & 0x08U) {
+			return -1;
+		}
+		return unz_copy(u, (uint_fast64_t)hdr[18U] |
+				(uint_fast64_t)hdr[19U] << 8U |
+				(uint_fast64_t)hdr[20U] << 16U |
+				(uint_fast64_t)hdr[21U] << 24U);
+#if defined HAVE_ZLIB
+	case 8U:
+		/* raw deflate, it knows where to stop */
+		return unz_zlib(u, -MAX_WBITS);
+#endif	/* HAVE_ZLIB */
+	default:
+		break;
+	}
+	return -1;
+}
+
+static void*
+unz_thread(void *arg)
+{
+	struct unz_s *u = arg;
+	int rc = -1;
+
+	switch (u->typ) {
+	case UNZ_ZIP:
+		rc = unz_zip(u);
+		break;
+#if defined HAVE_ZLIB
+	case UNZ_GZ:
+		rc = unz_zlib(u, MAX_WBITS + 16);
+		break;
+#endif	/* HAVE_ZLIB */
+#if defined HAVE_LZMA
+	case UNZ_XZ:
+		rc = unz_lzma(u);
+		break;
+#endif	/* HAVE_LZMA */
+	default:
+		break;
+	}
+	blk_eof(u, rc);
+	return NULL;
+}
+
+
+int
+unz_magicp(const char *buf, size_t len)
+{
+	switch (unz_typ((const unsigned char*)buf, len)) {
+#if defined HAVE_ZLIB
+	case UNZ_GZ:
+#endif	/* HAVE_ZLIB */
+#if defined HAVE_LZMA
+	case UNZ_XZ:
+#endif	/* HAVE_LZMA */
+	case UNZ_ZIP:
+		return 1;
+	default:
+		break;
+	}
+	return 0;
+}
+
+unz_t
+make_unz(int fd)
+{
+	struct unz_s *u;
+	ssize_t npk;
+
+	if (UNLIKELY((u = calloc(1U, sizeof(*u))) == NULL)) {
+		return NULL;
+	}
+	u->fd = fd;
+	if ((npk = raw_full(u, u->pk, sizeof(u->pk))) < 0) {
+		goto nul;
+	}
+	u->npk = npk;
+	if (!unz_magicp((const char*)u->pk, u->npk)) {
+		/* pass through */
+		return u;
+	}
+	u->typ = unz_typ(u->pk, u->npk);
+	for (size_t i = 0U; i < countof(u->blk); i++) {
+		if (UNLIKELY((u->blk[i].buf = malloc(BLKZ)) == NULL)) {
+			goto fre;
+		}
+	}
+	pthread_mutex_init(&u->mtx, NULL);
+	pthread_cond_init(&u->cnd, NULL);
+	if (UNLIKELY(pthread_create(&u->th, NULL, unz_thread, u))) {
+		pthread_cond_destroy(&u->cnd);
+		pthread_mutex_destroy(&u->mtx);
+		goto fre;
+	}
+	return u;
+
+fre:
+	for (size_t i = 0U; i < countof(u->blk); i++) {
+		free(u->blk[i].buf);
+	}
+nul:
+	free(u);
+	return NULL;
+}
+
+int
+free_unz(unz_t u)
+{
+	int rc = 0;
+
+	if (u->typ != UNZ_NONE) {
+		pthread_mutex_lock(&u->mtx);
+		u->stopp = true;
+		pthread_cond_broadcast(&u->cnd);
+		pthread_mutex_unlock(&u->mtx);
+		pthread_join(u->th, NULL);
+		pthread_cond_destroy(&u->cnd);
+		pthread_mutex_destroy(&u->mtx);
+		for (size_t i = 0U; i < countof(u->blk); i++) {
+			free(u->blk[i].buf);
+		}
+		rc = u->rc;
+	}
+	free(u);
+	return rc;
+}
+
+ssize_t
+unz_read(unz_t u, void *buf, size_t len)
+{
+	size_t i, z;
+
+	if (u->typ == UNZ_NONE) {
+		return raw_read(u, buf, len);
+	}
+	pthread_mutex_lock(&u->mtx);
+	while (u->nc == u->np && !u->eofp) {
+		pthread_cond_wait(&u->cnd, &u->mtx);
+	}
+	if (u->nc == u->np) {
+		/* drained */
+		pthread_mutex_unlock(&u->mtx);
+		return u->rc < 0 ? -1 : 0;
+	}
+	pthread_mutex_unlock(&u->mtx);
+
+	/* the block at NC is ours until we advance NC */
+	i = u->nc % NBLK;
+	z = u->blk[i].len - u->bo < len ? u->blk[i].len - u->bo : len;
+	memcpy(buf, u->blk[i].buf + u->bo, z);
+	if ((u->bo += z) >= u->blk[i].len) {
+		/* hand the block back */
+		u->bo = 0U;
+		pthread_mutex_lock(&u->mtx);
+		u->nc++;
+		pthread_cond_broadcast(&u->cnd);
+		pthread_mutex_unlock(&u->mtx);
+	}
+	return z;
+}
+
+/* unz.c ends here */
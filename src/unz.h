@@ -0,0 +1,68 @@
+/*** unz.h -- in-process decompression of golden copies
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+#if !defined INCLUDED_unz_h_
+#define INCLUDED_unz_h_
+
+#include <stddef.h>
+#include <unistd.h>
+
+typedef struct unz_s *unz_t;
+
+/**
+ * Return non-0 if BUF (of length LEN) starts with the magic bytes of
+ * a zip, gzip or xz file we know how to inflate. */
+extern int unz_magicp(const char *buf, size_t len);
+
+/**
+ * Return a reader on FD.
+ * If FD's contents are compressed they are inflated on a separate
+ * thread, otherwise reads are passed through to FD. */
+extern unz_t make_unz(int fd);
+
+/**
+ * Stop inflating and free resources associated with U.
+ * FD is not closed.
+ * Return 0 if all of the input could be inflated, -1 otherwise. */
+extern int free_unz(unz_t u);
+
+/**
+ * Read up to LEN bytes of inflated data into BUF.
+ * Return the number of bytes read, 0 at the end of input or -1 on
+ * error. */
+extern ssize_t unz_read(unz_t u, void *buf, size_t len);
+
+#endif	/* INCLUDED_unz_h_ */
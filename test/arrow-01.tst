@@ -0,0 +1,10 @@
+## records pass through libgleis' Arrow builder and come out of the
+## C data interface as they went in, and --arrow files are stable
+for f in esc plei ent; do
+	"${GLEIS2RDF}" --tsv "${srcdir}/${f}.xml" > tsv
+	"${builddir}/arrowchk" < tsv | diff tsv -
+done
+"${GLEIS2RDF}" --arrow "${srcdir}/esc.xml" "${srcdir}/ent.xml" > out
+"${GLEIS2RDF}" --arrow -P libxml "${srcdir}/esc.xml" "${srcdir}/ent.xml" | \
+	cmp out -
+cksum < out
@@ -0,0 +1,213 @@
+/*** arrowchk.c -- consume Arrow exports through the C data interface
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+/* read TSV from stdin, hand it to an arrow builder, export schema and
+ * batch through the C data interface and print what a consumer sees,
+ * which should be the TSV we started with */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "arrow.h"
+
+#define NCOL	(64U)
+
+static size_t
+tsv_split(char **v, size_t *z, size_t n, char *ln, size_t lz)
+{
+	size_t i = 0U;
+
+	for (char *tp; i < n; ln = tp + 1U) {
+		if ((tp = memchr(ln, '\t', lz)) == NULL) {
+			tp = ln + lz;
+		}
+		v[i] = ln;
+		z[i] = tp - ln;
+		lz -= z[i];
+		i++;
+		if (!lz--) {
+			break;
+		}
+	}
+	return i;
+}
+
+static int
+utf8_val(const struct ArrowArray *a, int64_t row, const char **v, size_t *z)
+{
+	const uint8_t *const vld = a->buffers[0U];
+	const int32_t *const off = a->buffers[1U];
+	const char *const dat = a->buffers[2U];
+	const int64_t i = a->offset + row;
+
+	if (vld != NULL && !(vld[i / 8] >> (i % 8) & 1U)) {
+		*v = NULL;
+		*z = 0U;
+		return 0;
+	} else if (off[i + 1] < off[i]) {
+		return -1;
+	}
+	*v = dat + off[i];
+	*z = off[i + 1] - off[i];
+	return 0;
+}
+
+static int
+col_val(const struct ArrowSchema *s, const struct ArrowArray *a, int64_t row,
+	const char **v, size_t *z)
+{
+	if (s->dictionary == NULL) {
+		return utf8_val(a, row, v, z);
+	} else {
+		/* int32 indices into a utf8 dictionary */
+		const uint8_t *const vld = a->buffers[0U];
+		const int32_t *const idx = a->buffers[1U];
+		const int64_t i = a->offset + row;
+
+		if (vld != NULL && !(vld[i / 8] >> (i % 8) & 1U)) {
+			*v = NULL;
+			*z = 0U;
+			return 0;
+		} else if (idx[i] < 0 || idx[i] >= a->dictionary->length) {
+			return -1;
+		}
+		return utf8_val(a->dictionary, idx[i], v, z);
+	}
+}
+
+int
+main(void)
+{
+	char *ln = NULL;
+	size_t lz = 0U;
+	ssize_t nrd;
+	char *hdr[NCOL];
+	size_t hz[NCOL];
+	size_t ncol;
+	struct ArrowSchema s;
+	struct ArrowArray a;
+	arrow_t b;
+	int rc = 1;
+
+	if ((nrd = getline(&ln, &lz, stdin)) <= 0) {
+		return 1;
+	}
+	ln[--nrd] = '\0';
+	ncol = tsv_split(hdr, hz, NCOL, strdup(ln), nrd);
+	for (size_t i = 0U; i < ncol; i++) {
+		hdr[i][hz[i]] = '\0';
+	}
+	/* dictionary-code every other column */
+	if ((b = make_arrow((const char**)hdr, ncol, 0xaaaaaaaaU)) == NULL) {
+		return 1;
+	}
+	while ((nrd = getline(&ln, &lz, stdin)) > 0) {
+		char *v[NCOL];
+		size_t z[NCOL];
+
+		ln[--nrd] = '\0';
+		if (tsv_split(v, z, ncol, ln, nrd) != ncol) {
+			goto fre;
+		}
+		for (size_t i = 0U; i < ncol; i++) {
+			if (!z[i]) {
+				v[i] = NULL;
+			}
+		}
+		if (arrow_add(b, (const char**)v, z) < 0) {
+			goto fre;
+		}
+	}
+	if (arrow_schema(b, &s) < 0) {
+		goto fre;
+	} else if (arrow_batch(b, &a) < 0) {
+		goto rel;
+	}
+	/* don't need the builder for any of this */
+	free_arrow(b);
+	b = NULL;
+
+	if (strcmp(s.format, "+s") || s.n_children != (int64_t)ncol ||
+	    a.n_children != (int64_t)ncol) {
+		goto relb;
+	}
+	for (size_t i = 0U; i < ncol; i++) {
+		const struct ArrowSchema *c = s.children[i];
+
+		if (strcmp(c->format, c->dictionary ? "i" : "u") ||
+		    (c->dictionary && strcmp(c->dictionary->format, "u")) ||
+		    !(c->flags & ARROW_FLAG_NULLABLE)) {
+			goto relb;
+		}
+		printf("%s%c", c->name, i + 1U < ncol ? '\t' : '\n');
+	}
+	for (int64_t r = 0; r < a.length; r++) {
+		for (size_t i = 0U; i < ncol; i++) {
+			const char *v;
+			size_t z;
+
+			if (col_val(s.children[i], a.children[i], r, &v, &z) < 0) {
+				goto relb;
+			}
+			fwrite(v, 1U, z, stdout);
+			fputc(i + 1U < ncol ? '\t' : '\n', stdout);
+		}
+	}
+	rc = 0;
+
+relb:
+	a.release(&a);
+	if (a.release != NULL) {
+		rc = 1;
+	}
+rel:
+	s.release(&s);
+	if (s.release != NULL) {
+		rc = 1;
+	}
+fre:
+	if (b != NULL) {
+		free_arrow(b);
+	}
+	free(hdr[0U]);
+	free(ln);
+	return rc;
+}
+
+/* arrowchk.c ends here */
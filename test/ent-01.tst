@@ -0,0 +1,5 @@
+## character references and double escapes come out decoded, once
+"${GLEIS2RDF}" "${srcdir}/ent.xml" > out
+"${GLEIS2RDF}" -P libxml "${srcdir}/ent.xml" | diff out -
+"${GLEIS2RDF}" -B3 "${srcdir}/ent.xml" | diff out -
+grep -vF "@prefix" out
@@ -0,0 +1,10 @@
+## only the selected fields make it, the LEI always does
+for f in lei name,status form,jurisdiction irdate,ludate; do
+	"${GLEIS2RDF}" --fields=${f} "${srcdir}/esc.xml" > out
+	"${GLEIS2RDF}" --fields=${f} -P libxml "${srcdir}/esc.xml" | diff out -
+	"${GLEIS2RDF}" --fields=${f} -j2 "${srcdir}/esc.xml" | diff out -
+	grep -vF "@prefix" out
+done
+if "${GLEIS2RDF}" --fields=lei,colour "${srcdir}/esc.xml" > /dev/null 2>&1; then
+	exit 1
+fi
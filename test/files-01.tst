@@ -0,0 +1,16 @@
+## several files with --jobs come out in argument order, even when
+## their buffers have to be spilled, --unordered just reorders files
+sed '/<lei:LEIRecords>/q' "${srcdir}/esc.xml" > many.xml
+for i in 1 2 3 4 5 6 7 8; do
+	sed '1,/<lei:LEIRecords>/d; /<\/lei:LEIRecords>/,$d' "${srcdir}/esc.xml"
+done >> many.xml
+sed -n '/<\/lei:LEIRecords>/,$p' "${srcdir}/esc.xml" >> many.xml
+set -- many.xml "${srcdir}/cdf21.xml" "${srcdir}/plei.xml" many.xml \
+	"${srcdir}/ent.xml" many.xml "${srcdir}/esc.xml"
+"${GLEIS2RDF}" "$@" > seq
+for j in 2 3 8; do
+	"${GLEIS2RDF}" -j${j} "$@" | diff seq -
+	"${GLEIS2RDF}" -j${j} -O 4096 "$@" | diff seq -
+	"${GLEIS2RDF}" -j${j} -O 4096 --unordered "$@" | sort > uno
+	sort seq | diff - uno
+done
@@ -0,0 +1,31 @@
+#!/bin/sh
+## usage: gleis-test.sh TEST.tst
+## Run the shell snippet TEST.tst in a scratch directory and compare
+## its standard output with TEST.out, if there is one.
+## The snippet sees $GLEIS2RDF, the binary under test, $srcdir,
+## where the test files live, and $builddir, where check programs
+## live, and fails by exiting non-0.
+
+tst="${1}"
+name=`basename "${tst}" .tst`
+srcdir=`cd \`dirname "${tst}"\` && pwd`
+exp="${srcdir}/${name}.out"
+tmp="${name}.tmpd"
+builddir=`pwd`
+
+export srcdir
+export builddir
+: ${GLEIS2RDF:=`pwd`/../src/gleis2rdf}
+export GLEIS2RDF
+
+rm -rf -- "${tmp}" && mkdir -- "${tmp}" || exit 99
+cd "${tmp}" || exit 99
+
+if ! ${SHELL:-/bin/sh} -e "${srcdir}/${name}.tst" > stdout; then
+	echo "${name}: snippet failed" >&2
+	exit 1
+elif test -f "${exp}" && ! diff -u "${exp}" stdout; then
+	exit 1
+fi
+cd .. && rm -rf -- "${tmp}"
+exit 0
@@ -0,0 +1,21 @@
+## HDT output is the same bytes whichever way it's produced
+"${GLEIS2RDF}" --hdt "${srcdir}/esc.xml" "${srcdir}/cdf21.xml" > out
+for o in "-P libxml" "-j2" "-j3 -O 4096"; do
+	"${GLEIS2RDF}" --hdt ${o} "${srcdir}/esc.xml" "${srcdir}/cdf21.xml" | \
+		cmp out -
+done
+cksum < out
+## it decodes, with checksums, dictionary and triples intact, and
+## holds the statements of the n-triples output
+"${builddir}/hdtchk" < out > chk
+cat chk
+n=$("${GLEIS2RDF}" -n "${srcdir}/esc.xml" "${srcdir}/cdf21.xml" | sort -u | wc -l)
+grep -qx "triples	$((n))" chk
+## and there's no mixing it with other output formats
+for o in --tsv -n -q --snapshot; do
+	if "${GLEIS2RDF}" --hdt ${o} "${srcdir}/esc.xml" > mixed 2> err; then
+		exit 1
+	fi
+	grep -qF "more than one output format" err
+	test ! -s mixed
+done
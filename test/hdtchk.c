@@ -0,0 +1,463 @@
+/*** hdtchk.c -- check HDT files the way a reader sees them
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+/* read an HDT file from stdin, verify its checksums and the structure
+ * of its dictionary and triples independently of hdt.c, and print the
+ * control information, the header and the section counts */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+static const unsigned char *buf;
+static size_t len;
+static size_t pos;
+
+static void
+fail(const char *what)
+{
+	fprintf(stderr, "hdtchk: %s at offset %zu\n", what, pos);
+	exit(EXIT_FAILURE);
+}
+
+static uint8_t
+crc8(const unsigned char *p, size_t n)
+{
+	unsigned int c = 0U;
+
+	for (size_t i = 0U; i < n; i++) {
+		c ^= p[i];
+		for (int k = 0; k < 8; k++) {
+			c = (c << 1U ^ (c & 0x80U ? 0x07U : 0U)) & 0xffU;
+		}
+	}
+	return (uint8_t)c;
+}
+
+static uint16_t
+crc16(const unsigned char *p, size_t n)
+{
+	uint16_t c = 0U;
+
+	for (size_t i = 0U; i < n; i++) {
+		c ^= p[i];
+		for (int k = 0; k < 8; k++) {
+			c = (uint16_t)(c & 1U ? c >> 1U ^ 0xa001U : c >> 1U);
+		}
+	}
+	return c;
+}
+
+static uint32_t
+crc32c(const unsigned char *p, size_t n)
+{
+	uint32_t c = 0xffffffffU;
+
+	for (size_t i = 0U; i < n; i++) {
+		c ^= p[i];
+		for (int k = 0; k < 8; k++) {
+			c = c & 1U ? c >> 1U ^ 0x82f63b78U : c >> 1U;
+		}
+	}
+	return c ^ 0xffffffffU;
+}
+
+static const unsigned char*
+need(size_t n)
+{
+	const unsigned char *p = buf + pos;
+
+	if (n > len - pos) {
+		fail("premature end of file");
+	}
+	pos += n;
+	return p;
+}
+
+static uint_fast64_t
+rd_le(size_t n)
+{
+	const unsigned char *p = need(n);
+	uint_fast64_t x = 0U;
+
+	for (size_t i = n; i > 0U; i--) {
+		x = x << 8U | p[i - 1U];
+	}
+	return x;
+}
+
+static uint_fast64_t
+rd_vbyte(void)
+{
+	uint_fast64_t x = 0U;
+
+	for (unsigned int s = 0U; s < 64U; s += 7U) {
+		const unsigned char b = *need(1U);
+
+		x |= (uint_fast64_t)(b & 0x7fU) << s;
+		if (b & 0x80U) {
+			return x;
+		}
+	}
+	fail("overlong vbyte");
+	return 0U;
+}
+
+static const char*
+rd_cstr(void)
+{
+	const unsigned char *p = buf + pos;
+	const unsigned char *e = memchr(p, '\0', len - pos);
+
+	if (e == NULL) {
+		fail("unterminated string");
+	}
+	pos = e + 1U - buf;
+	return (const char*)p;
+}
+
+static void
+chk_crc8(size_t from)
+{
+	const uint8_t c = crc8(buf + from, pos - from);
+
+	if (rd_le(1U) != c) {
+		fail("crc8 mismatch");
+	}
+	return;
+}
+
+static void
+chk_crc32(size_t from)
+{
+	const uint32_t c = crc32c(buf + from, pos - from);
+
+	if (rd_le(4U) != c) {
+		fail("crc32 mismatch");
+	}
+	return;
+}
+
+static size_t
+prop(const char *props, const char *key)
+{
+/* the numeric value of KEY in the ;-separated PROPS */
+	const size_t kz = strlen(key);
+
+	for (const char *p = props; *p; p++) {
+		if (!strncmp(p, key, kz) && p[kz] == '=' &&
+		    (p == props || p[-1] == ';')) {
+			return strtoul(p + kz + 1U, NULL, 10);
+		}
+	}
+	fail("missing property");
+	return 0U;
+}
+
+static const char*
+rd_ci(unsigned int typ)
+{
+/* control information of type TYP, return its properties */
+	const size_t from = pos;
+	const char *fmt, *props;
+	uint16_t c;
+
+	if (memcmp(need(4U), "$HDT", 4U)) {
+		fail("no control information");
+	} else if (*need(1U) != typ) {
+		fail("unexpected section type");
+	}
+	fmt = rd_cstr();
+	props = rd_cstr();
+	c = crc16(buf + from, pos - from);
+	if (rd_le(2U) != c) {
+		fail("crc16 mismatch");
+	}
+	printf("%u\t%s\t%s\n", typ, fmt, props);
+	return props;
+}
+
+static uint64_t*
+rd_seq(size_t *n)
+{
+/* a log sequence, return its values */
+	const size_t from = pos;
+	unsigned int nb;
+	uint64_t *v;
+	size_t nby;
+
+	if (*need(1U) != 1U) {
+		fail("unknown sequence type");
+	} else if ((nb = *need(1U)) < 1U || nb > 64U) {
+		fail("bad sequence width");
+	}
+	*n = rd_vbyte();
+	chk_crc8(from);
+	nby = (nb * *n + 7U) / 8U;
+	if ((v = calloc(*n + 1U, sizeof(*v))) == NULL) {
+		fail("out of memory");
+	}
+	{
+		const size_t dat = pos;
+		const unsigned char *p = need(nby);
+
+		for (size_t i = 0U; i < *n; i++) {
+			for (unsigned int k = 0U; k < nb; k++) {
+				const size_t b = i * nb + k;
+
+				v[i] |= (uint64_t)(p[b / 8U] >> (b % 8U) & 1U) << k;
+			}
+		}
+		chk_crc32(dat);
+	}
+	return v;
+}
+
+static unsigned char*
+rd_bmp(size_t *n)
+{
+/* a plain bitmap, return its bits one per byte */
+	const size_t from = pos;
+	unsigned char *v;
+
+	if (*need(1U) != 1U) {
+		fail("unknown bitmap type");
+	}
+	*n = rd_vbyte();
+	chk_crc8(from);
+	if ((v = malloc(*n + 1U)) == NULL) {
+		fail("out of memory");
+	}
+	{
+		const size_t dat = pos;
+		const unsigned char *p = need((*n + 7U) / 8U);
+
+		for (size_t i = 0U; i < *n; i++) {
+			v[i] = (unsigned char)(p[i / 8U] >> (i % 8U) & 1U);
+		}
+		chk_crc32(dat);
+	}
+	return v;
+}
+
+static size_t
+rd_pfc(const char *name)
+{
+/* a front-coded dictionary section, check that its strings decode and
+ * come in strictly ascending order, return their number */
+	const size_t from = pos;
+	size_t n, nby, bz, nblk;
+	uint64_t *blk;
+	const unsigned char *txt;
+	char *prev = NULL;
+	size_t prez = 0U;
+	size_t q = 0U;
+
+	if (*need(1U) != 2U) {
+		fail("unknown dictionary section type");
+	}
+	n = rd_vbyte();
+	nby = rd_vbyte();
+	bz = rd_vbyte();
+	chk_crc8(from);
+	if (!bz) {
+		fail("zero block size");
+	}
+	blk = rd_seq(&nblk);
+	if (nblk != (n + bz - 1U) / bz + 1U || blk[nblk - 1U] != nby) {
+		fail("block offsets don't match the strings");
+	}
+	{
+		const size_t dat = pos;
+
+		txt = need(nby);
+		chk_crc32(dat);
+	}
+	for (size_t i = 0U; i < n; i++) {
+		size_t c = 0U, sz;
+		const unsigned char *e;
+		char *s;
+
+		if (i % bz == 0U) {
+			if (q != blk[i / bz]) {
+				fail("block offset mismatch");
+			}
+		} else {
+			unsigned int sh = 0U;
+			unsigned char b;
+
+			do {
+				if (q >= nby) {
+					fail("string data overrun");
+				}
+				b = txt[q++];
+				c |= (size_t)(b & 0x7fU) << sh;
+				sh += 7U;
+			} while (!(b & 0x80U));
+			if (c > prez) {
+				fail("prefix longer than previous string");
+			}
+		}
+		if ((e = memchr(txt + q, '\0', nby - q)) == NULL) {
+			fail("unterminated dictionary string");
+		}
+		sz = c + (e - (txt + q));
+		if ((s = malloc(sz + 1U)) == NULL) {
+			fail("out of memory");
+		}
+		if (c) {
+			memcpy(s, prev, c);
+		}
+		memcpy(s + c, txt + q, e - (txt + q));
+		s[sz] = '\0';
+		if (prev != NULL && strcmp(prev, s) >= 0) {
+			fail("dictionary strings out of order");
+		}
+		free(prev);
+		prev = s;
+		prez = sz;
+		q = e + 1U - txt;
+	}
+	if (q != nby) {
+		fail("trailing dictionary data");
+	}
+	free(prev);
+	free(blk);
+	printf("%s\t%zu\n", name, n);
+	return n;
+}
+
+int
+main(void)
+{
+	unsigned char *mb = NULL;
+	size_t zbuf = 0U;
+	const char *props;
+	size_t nsh, nsu, npr, nob;
+	size_t nby, nbz, nsy, nsz;
+	unsigned char *by, *bz;
+	uint64_t *sy, *sz;
+
+	/* slurp */
+	for (size_t nrd;; len += nrd) {
+		if (len + 65536U > zbuf) {
+			unsigned char *nu = realloc(mb, zbuf = 2U * zbuf + 65536U);
+
+			if (nu == NULL) {
+				fail("out of memory");
+			}
+			mb = nu;
+		}
+		if (!(nrd = fread(mb + len, 1U, 65536U, stdin))) {
+			break;
+		}
+	}
+	buf = mb;
+
+	rd_ci(1U);
+	props = rd_ci(2U);
+	{
+		const size_t hz = prop(props, "length");
+		const unsigned char *h = need(hz);
+
+		fwrite(h, 1U, hz, stdout);
+	}
+
+	props = rd_ci(3U);
+	if (prop(props, "mapping") != 2U) {
+		fail("unknown dictionary mapping");
+	}
+	nsh = rd_pfc("shared");
+	nsu = rd_pfc("subjects");
+	npr = rd_pfc("predicates");
+	nob = rd_pfc("objects");
+	if (prop(props, "elements") != nsh + nsu + npr + nob) {
+		fail("dictionary elements don't add up");
+	}
+
+	props = rd_ci(4U);
+	by = rd_bmp(&nby);
+	bz = rd_bmp(&nbz);
+	sy = rd_seq(&nsy);
+	sz = rd_seq(&nsz);
+	if (pos != len) {
+		fail("trailing garbage");
+	} else if (nby != nsy || nbz != nsz || prop(props, "numTriples") != nsz) {
+		fail("triple counts don't add up");
+	}
+	/* walk the triples, subjects are implicit */
+	{
+		size_t s = 1U, z = 0U;
+
+		for (size_t y = 0U; y < nsy; y++) {
+			if (sy[y] < 1U || sy[y] > npr) {
+				fail("predicate out of range");
+			} else if (y && !by[y - 1U] && sy[y] <= sy[y - 1U]) {
+				fail("predicates out of order");
+			}
+			for (size_t z0 = z; z < nsz; z++) {
+				if (sz[z] < 1U || sz[z] > nsh + nob) {
+					fail("object out of range");
+				} else if (z > z0 && sz[z] <= sz[z - 1U]) {
+					fail("objects out of order");
+				} else if (bz[z]) {
+					break;
+				}
+			}
+			if (z++ >= nsz) {
+				fail("objects run out");
+			}
+			s += by[y];
+		}
+		if (z != nsz || (nsy && !by[nsy - 1U]) ||
+		    s - 1U != nsh + nsu) {
+			fail("subjects don't add up");
+		}
+	}
+	printf("triples\t%zu\n", nsz);
+
+	free(by);
+	free(bz);
+	free(sy);
+	free(sz);
+	free(mb);
+	return EXIT_SUCCESS;
+}
+
+/* hdtchk.c ends here */
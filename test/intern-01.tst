@@ -0,0 +1,32 @@
+## more distinct values than the intern tables hold, each record must
+## still get its own, whether rendered afresh or reused
+awk 'BEGIN {
+	print "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+	print "<lei:LEIData xmlns:lei=\"http://www.gleif.org/data/schema/leidata/2016\">"
+	print "<lei:LEIRecords>"
+	for (i = 1; i <= 10000; i++) {
+		f = (i - 1) % 5000 + 1
+		printf "<lei:LEIRecord><lei:LEI>%020d</lei:LEI><lei:Entity>", i
+		printf "<lei:LegalForm><lei:OtherLegalForm>F\"%d\"</lei:OtherLegalForm>", f
+		printf "</lei:LegalForm><lei:LegalJurisdiction>J%d</lei:LegalJurisdiction>", f
+		print "</lei:Entity></lei:LEIRecord>"
+	}
+	print "</lei:LEIRecords>"
+	print "</lei:LEIData>"
+}' > many.xml
+for o in "" "-j3" "-P libxml"; do
+	"${GLEIS2RDF}" -n ${o} many.xml > nt
+	## the numbers in subject and value have to agree
+	sed -n 's|^<[^>]*/0*\([0-9]*\)> <[^>]*/LegalForm> "F\\"\([0-9]*\)\\"" \.$|\1 \2|p
+s|^<[^>]*/0*\([0-9]*\)> <[^>]*isRecognizedIn> <[^#]*#J\([0-9]*\)> \.$|\1 \2|p' \
+		nt | awk '{ n++ } ($1 - 1) % 5000 + 1 != $2 { bad++ }
+		END { print n + 0, "values,", bad + 0, "wrong" }'
+done
+## in turtle the subject starts the record's block
+"${GLEIS2RDF}" -j2 many.xml | \
+	sed -n 's|^lei:0*\([0-9]*\) .*|s \1|p
+s|^ *leiroc:LegalForm """F\\"\([0-9]*\)\\"""" ;$|v \1|p
+s|^.*isRecognizedIn <[^#]*#J\([0-9]*\)> .*|v \1|p' | \
+	awk '$1 == "s" { s = $2; next } { n++ }
+	(s - 1) % 5000 + 1 != $2 { bad++ }
+	END { print n + 0, "values,", bad + 0, "wrong" }'
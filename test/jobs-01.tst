@@ -0,0 +1,6 @@
+## chunked conversion keeps the records in file order
+"${GLEIS2RDF}" "${srcdir}/esc.xml" > seq
+for j in 2 3 4; do
+	"${GLEIS2RDF}" -j${j} "${srcdir}/esc.xml" | diff seq -
+	"${GLEIS2RDF}" -j${j} -P libxml "${srcdir}/esc.xml" | diff seq -
+done
@@ -0,0 +1,12 @@
+## a JSON object per record, JSON-LD puts its context in front
+for f in ndjson jsonld; do
+	"${GLEIS2RDF}" --${f} "${srcdir}/esc.xml" > ${f}
+	"${GLEIS2RDF}" --${f} -P libxml "${srcdir}/esc.xml" | diff ${f} -
+	"${GLEIS2RDF}" --${f} -j2 "${srcdir}/esc.xml" | diff ${f} -
+	cat ${f}
+done
+"${GLEIS2RDF}" --ndjson "${srcdir}/plei.xml" "${srcdir}/ent.xml"
+## the language is escaped like any other string
+sed "11s|xml:lang=\"de\"|xml:lang='a\"\\\\\&#9;b'|" "${srcdir}/esc.xml" > lang.xml
+grep -qF "xml:lang='a\"\\&#9;b'" lang.xml
+"${GLEIS2RDF}" --ndjson lang.xml | sed -n 1p
@@ -0,0 +1,6 @@
+## parsing from a mapping gives what libxml's own reading gives
+"${GLEIS2RDF}" -P libxml "${srcdir}/esc.xml" > ref
+"${GLEIS2RDF}" -m -P libxml "${srcdir}/esc.xml" | diff ref -
+"${GLEIS2RDF}" -m "${srcdir}/esc.xml" | diff ref -
+"${GLEIS2RDF}" -m "${srcdir}/cdf21.xml" "${srcdir}/esc.xml" > both
+"${GLEIS2RDF}" -P libxml "${srcdir}/cdf21.xml" "${srcdir}/esc.xml" | diff both -
@@ -0,0 +1,12 @@
+## a named graph per last update date, or per content date
+for k in ludate content; do
+	"${GLEIS2RDF}" --nquads=${k} "${srcdir}/esc.xml" > ${k}
+	"${GLEIS2RDF}" --nquads=${k} -P libxml "${srcdir}/esc.xml" | diff ${k} -
+	"${GLEIS2RDF}" --nquads=${k} -j2 "${srcdir}/esc.xml" | diff ${k} -
+	cat ${k}
+done
+## last update date is the default
+"${GLEIS2RDF}" -q "${srcdir}/esc.xml" | diff ludate -
+## graph IRIs are escaped like any other
+sed '84s|T23:59:59.000Z|& {"x"}\&lt;|' "${srcdir}/esc.xml" > odd.xml
+"${GLEIS2RDF}" -q odd.xml | grep -m1 '/updated/2018-02-28'
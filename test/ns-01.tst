@@ -0,0 +1,13 @@
+## records are recognised by namespace, not by prefix, and look-alikes
+## from other namespaces are left alone
+"${GLEIS2RDF}" "${srcdir}/esc.xml" > ref
+sed 's|<\(/*\)lei:|<\1|g; s|xmlns:lei=|xmlns=|' "${srcdir}/esc.xml" > dflt.xml
+sed 's|<\(/*\)lei:|<\1gl:|g; s|xmlns:lei=|xmlns:gl=|' "${srcdir}/esc.xml" > gl.xml
+sed 's|<lei:LegalName|<x:LegalName xmlns:x="urn:x">Not this</x:LegalName>&|
+s|<lei:LEI>|<x:LEI xmlns:x="urn:x">00000000000000000000</x:LEI>&|' \
+	"${srcdir}/esc.xml" > foreign.xml
+for f in dflt gl foreign; do
+	for o in "" "-P libxml" "-j2"; do
+		"${GLEIS2RDF}" ${o} ${f}.xml | diff ref -
+	done
+done
@@ -0,0 +1,10 @@
+## more namespace declarations on one element than attributes fit
+"${GLEIS2RDF}" "${srcdir}/esc.xml" > ref
+decl=
+for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+	decl="${decl} xmlns:x${i}=\"urn:x:${i}\""
+done
+sed "s|<lei:LEIData|&${decl}|" "${srcdir}/esc.xml" > many.xml
+for o in "" "-P builtin" "-P libxml" "-j2"; do
+	"${GLEIS2RDF}" ${o} many.xml | diff ref -
+done
@@ -0,0 +1,10 @@
+## one self-contained statement per line, the same whichever way
+## the file is cut up
+"${GLEIS2RDF}" -n "${srcdir}/esc.xml" > out
+"${GLEIS2RDF}" -n -P libxml "${srcdir}/esc.xml" | diff out -
+"${GLEIS2RDF}" -n -j2 "${srcdir}/esc.xml" | diff out -
+"${GLEIS2RDF}" -n -j2 < "${srcdir}/esc.xml" | diff out -
+## statements without literals consist of IRIs N-Triples allows
+grep -v '"' out | grep -Ev '^(<[^[:cntrl:] <>"{}|^`\]*> )+\.$' > bad || :
+test ! -s bad
+cat out
@@ -0,0 +1,15 @@
+## output block size and flushing don't change a byte
+sed '/<lei:LEIRecords>/q' "${srcdir}/esc.xml" > many.xml
+for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16; do
+	sed '1,/<lei:LEIRecords>/d; /<\/lei:LEIRecords>/,$d' "${srcdir}/esc.xml"
+done >> many.xml
+sed -n '/<\/lei:LEIRecords>/,$p' "${srcdir}/esc.xml" >> many.xml
+"${GLEIS2RDF}" many.xml > ref
+"${GLEIS2RDF}" -n many.xml > nt
+for o in "-O 4096" "-O 4k" "-O 5000" "-O 1M" "-u" "-u -O 4096" "-O 1"; do
+	"${GLEIS2RDF}" ${o} many.xml > out
+	diff ref out
+	"${GLEIS2RDF}" ${o} many.xml | diff ref -
+	"${GLEIS2RDF}" ${o} -j2 many.xml | diff ref -
+	"${GLEIS2RDF}" ${o} -n many.xml | diff nt -
+done
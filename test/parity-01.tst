@@ -0,0 +1,6 @@
+## the builtin tokeniser and libxml agree on every fixture
+for x in esc cdf21 plei; do
+	"${GLEIS2RDF}" "${srcdir}/${x}.xml" > builtin
+	"${GLEIS2RDF}" -P libxml "${srcdir}/${x}.xml" > libxml
+	diff builtin libxml
+done
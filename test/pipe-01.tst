@@ -0,0 +1,10 @@
+## stdin can't be split, records go through the writer thread instead
+for f in esc cdf21 plei ent; do
+	"${GLEIS2RDF}" "${srcdir}/${f}.xml" > seq
+	"${GLEIS2RDF}" -j2 < "${srcdir}/${f}.xml" | diff seq -
+	cat "${srcdir}/${f}.xml" | "${GLEIS2RDF}" -j3 | diff seq -
+	"${GLEIS2RDF}" -j2 -P libxml < "${srcdir}/${f}.xml" | diff seq -
+	"${GLEIS2RDF}" -j2 -u -B5 < "${srcdir}/${f}.xml" | diff seq -
+	"${GLEIS2RDF}" --tsv "${srcdir}/${f}.xml" > seq
+	"${GLEIS2RDF}" -j2 --tsv < "${srcdir}/${f}.xml" | diff seq -
+done
@@ -0,0 +1,14 @@
+## without --jobs records go through the writer thread if there's more
+## than one CPU, -j1 converts on one thread, both agree
+set -- "${srcdir}/esc.xml" "${srcdir}/plei.xml" "${srcdir}/ent.xml"
+for o in "" "-n" "-q" "--tsv" "--ndjson" "--hdt" "--arrow" "--snapshot" \
+	"-P libxml" "-m" "-u -B5" "-f lei,name"; do
+	"${GLEIS2RDF}" -j1 ${o} "$@" > one
+	"${GLEIS2RDF}" ${o} "$@" | cmp one -
+	"${GLEIS2RDF}" -j1 ${o} < "${srcdir}/esc.xml" > one
+	"${GLEIS2RDF}" ${o} < "${srcdir}/esc.xml" | cmp one -
+done
+## snapshots are replayed through it, too
+"${GLEIS2RDF}" --snapshot "$@" > snap
+"${GLEIS2RDF}" -j1 snap > one
+"${GLEIS2RDF}" snap | cmp one -
@@ -0,0 +1,14 @@
+## libxml's push parser sees the same records in pieces of any size
+"${GLEIS2RDF}" "${srcdir}/esc.xml" > whole
+for b in 1 7 4096; do
+	"${GLEIS2RDF}" -B${b} "${srcdir}/esc.xml" | diff whole -
+	"${GLEIS2RDF}" -B${b} -j2 "${srcdir}/esc.xml" | diff whole -
+	"${GLEIS2RDF}" -B${b} < "${srcdir}/esc.xml" | diff whole -
+done
+## pushing only works with libxml
+if "${GLEIS2RDF}" -B -m "${srcdir}/esc.xml" > /dev/null 2>&1; then
+	exit 1
+fi
+if "${GLEIS2RDF}" -B -P builtin "${srcdir}/esc.xml" > /dev/null 2>&1; then
+	exit 1
+fi
@@ -0,0 +1,18 @@
+## one parser serves all files, a broken one doesn't spoil the rest
+head -n 20 "${srcdir}/esc.xml" > broken.xml
+for o in "" "-P libxml" "-m"; do
+	for f in esc plei ent cdf21 skip; do
+		"${GLEIS2RDF}" ${o} "${srcdir}/${f}.xml"
+	done > each
+	"${GLEIS2RDF}" ${o} "${srcdir}/esc.xml" "${srcdir}/plei.xml" \
+		"${srcdir}/ent.xml" "${srcdir}/cdf21.xml" \
+		"${srcdir}/skip.xml" > all
+	diff each all
+	if "${GLEIS2RDF}" ${o} "${srcdir}/esc.xml" broken.xml \
+		"${srcdir}/plei.xml" > part 2> err; then
+		exit 1
+	fi
+	grep -qF "cannot convert \`broken.xml'" err
+	"${GLEIS2RDF}" ${o} "${srcdir}/plei.xml" | tail -n 4 > plei
+	tail -n 4 part | diff plei -
+done
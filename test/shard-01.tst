@@ -0,0 +1,22 @@
+## records go to the shard their LEI hashes to, the manifest counts
+## them, and together the shards hold what a single file would
+set -- "${srcdir}/esc.xml" "${srcdir}/ent.xml" "${srcdir}/plei.xml"
+"${GLEIS2RDF}" -n --shards=3 --output-prefix=part- "$@" > stdout
+test ! -s stdout
+cat part-manifest.tsv
+"${GLEIS2RDF}" -n "$@" | LC_ALL=C sort > all
+cat part-0.nt part-1.nt part-2.nt | LC_ALL=C sort | diff all -
+## the partitioning doesn't depend on parser or threads
+for o in "-P libxml" "-j2" "-j3 -O 4096"; do
+	"${GLEIS2RDF}" -n --shards=3 --output-prefix=again- ${o} "$@"
+	for i in 0 1 2; do
+		cmp part-${i}.nt again-${i}.nt
+	done
+done
+## every TSV shard has a header, the default prefix is shard-
+"${GLEIS2RDF}" --tsv --shards=2 "$@"
+cat shard-manifest.tsv
+head -n 1 shard-0.tsv shard-1.tsv
+if "${GLEIS2RDF}" --hdt --shards=2 "$@" 2> /dev/null; then
+	exit 1
+fi
@@ -0,0 +1,20 @@
+## a snapshot holds the records ordered by LEI and converts like them
+set -- "${srcdir}/esc.xml" "${srcdir}/plei.xml" "${srcdir}/ent.xml"
+"${GLEIS2RDF}" --snapshot "$@" > snap
+"${GLEIS2RDF}" --snapshot -P libxml "$@" | cmp snap -
+"${GLEIS2RDF}" --snapshot -j2 "$@" | cmp snap -
+## converting a snapshot again changes nothing
+"${GLEIS2RDF}" --snapshot snap | cmp snap -
+"${GLEIS2RDF}" --csv "$@" > csv
+head -n 1 csv > sorted
+sed 1d csv | LC_ALL=C sort >> sorted
+"${GLEIS2RDF}" --csv snap | diff sorted -
+cksum < snap
+## libgleis reads them, too
+"${builddir}/snapchk" snap
+"${builddir}/snapchk" snap 5493002ZDLGXZ4N3KH81 0292001234567890AB12 \
+	00000000000000000000
+if "${GLEIS2RDF}" --snapshot --nquads "$@" > mixed 2> /dev/null; then
+	exit 1
+fi
+test ! -s mixed
@@ -0,0 +1,95 @@
+/*** snapchk.c -- read snapshots through libgleis
+ *
+ * Copyright (C) 2014-2018  Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of gleis.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ **/
+/* print snapshot FILE as TSV, or just the rows of the LEIs given */
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdio.h>
+#include <string.h>
+#include "snap.h"
+
+static void
+prrow(smap_t m, size_t row)
+{
+	const size_t ncol = smap_ncol(m);
+
+	for (size_t j = 0U; j < ncol; j++) {
+		const char *v;
+		size_t z;
+
+		if ((v = smap_val(m, row, j, &z)) != NULL) {
+			fwrite(v, 1U, z, stdout);
+		}
+		fputc(j + 1U < ncol ? '\t' : '\n', stdout);
+	}
+	return;
+}
+
+int
+main(int argc, char *argv[])
+{
+	smap_t m;
+	int rc = 0;
+
+	if (argc < 2 || (m = smap_open(argv[1])) == NULL) {
+		return 1;
+	}
+	for (size_t j = 0U, ncol = smap_ncol(m); j < ncol; j++) {
+		if (smap_col(m, smap_name(m, j)) != (ssize_t)j) {
+			rc = 1;
+		}
+		printf("%s%c", smap_name(m, j), j + 1U < ncol ? '\t' : '\n');
+	}
+	if (argc == 2) {
+		for (size_t i = 0U, nrow = smap_nrow(m); i < nrow; i++) {
+			prrow(m, i);
+		}
+	}
+	for (int i = 2; i < argc; i++) {
+		ssize_t row;
+
+		if ((row = smap_find(m, argv[i], strlen(argv[i]))) < 0) {
+			printf("%s not found\n", argv[i]);
+			continue;
+		}
+		prrow(m, row);
+	}
+	smap_close(m);
+	return rc;
+}
+
+/* snapchk.c ends here */
@@ -0,0 +1,10 @@
+## truncated files must not pass for complete ones
+for n in 10 29 49 70 79 88; do
+	head -n ${n} "${srcdir}/esc.xml" > trunc.xml
+	for o in "" "-P libxml" "-m" "-j2"; do
+		if "${GLEIS2RDF}" ${o} trunc.xml > /dev/null 2> err; then
+			exit 1
+		fi
+		grep -qF "cannot convert" err
+	done
+done
@@ -0,0 +1,14 @@
+## delimited output, tabs and backslashes escaped in TSV, quotes
+## doubled and separators quoted in CSV
+for f in tsv csv; do
+	"${GLEIS2RDF}" --${f} "${srcdir}/esc.xml" > ${f}
+	"${GLEIS2RDF}" --${f} -P libxml "${srcdir}/esc.xml" | diff ${f} -
+	"${GLEIS2RDF}" --${f} -j2 "${srcdir}/esc.xml" | diff ${f} -
+	cat ${f}
+	"${GLEIS2RDF}" --${f} "${srcdir}/plei.xml" "${srcdir}/ent.xml"
+done
+## the language is escaped like any other field
+sed "11s|xml:lang=\"de\"|xml:lang='a,\"\\\\\&#9;b'|" "${srcdir}/esc.xml" > lang.xml
+grep -qF "xml:lang='a,\"\\&#9;b'" lang.xml
+"${GLEIS2RDF}" --tsv lang.xml | sed -n 2p
+"${GLEIS2RDF}" --csv lang.xml | sed -n 2p
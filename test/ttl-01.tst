@@ -0,0 +1,6 @@
+## turtle literals and IRIs escape quotes, backslashes, tabs and
+## newlines and pass UTF-8 through, astral planes included
+"${GLEIS2RDF}" "${srcdir}/esc.xml" > out
+"${GLEIS2RDF}" -P libxml "${srcdir}/esc.xml" | diff out -
+"${GLEIS2RDF}" -j2 "${srcdir}/esc.xml" | diff out -
+cat out
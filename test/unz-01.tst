@@ -0,0 +1,9 @@
+## compressed golden copies convert like the plain file, mapped,
+## chunked or piped; $UNZ lists the copies this build can read
+"${GLEIS2RDF}" "${srcdir}/esc.xml" > plain
+for f in ${UNZ}; do
+	for o in "" -m -j2 -B "-P libxml"; do
+		"${GLEIS2RDF}" ${o} "${srcdir}/${f}" | diff plain -
+	done
+	"${GLEIS2RDF}" < "${srcdir}/${f}" | diff plain -
+done
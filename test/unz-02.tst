@@ -0,0 +1,43 @@
+## broken compressed input is an error, never a silent short read
+no() {
+	for o in "" -m -j2; do
+		"${GLEIS2RDF}" ${o} "${1}" 2>&1 >/dev/null | \
+			grep -q "cannot convert"
+	done
+	"${GLEIS2RDF}" < "${1}" 2>&1 >/dev/null | grep -q "cannot convert"
+}
+
+## chop Z bytes off the end of FILE
+chop() {
+	n=`wc -c < "${1}"`
+	head -c `expr ${n} - ${2}` "${1}"
+}
+
+## stored entries with a data descriptor have no length upfront
+no "${srcdir}/esc-dd.zip"
+## stored entry cut short
+chop "${srcdir}/esc-st.zip" 3000 > st.zip
+no st.zip
+
+for f in ${UNZ}; do
+	case "${f}" in
+	(*.gz)
+		## trailer missing, the deflate data itself is complete
+		chop "${srcdir}/${f}" 8 > tr.gz
+		no tr.gz
+		## trailing garbage is neither EOF nor another member
+		{ cat "${srcdir}/${f}"; printf 'garbage'; } > gb.gz
+		no gb.gz
+		;;
+	(*.xz)
+		## stream footer missing
+		chop "${srcdir}/${f}" 12 > tr.xz
+		no tr.xz
+		;;
+	(*.zip)
+		## deflated entry cut short
+		chop "${srcdir}/${f}" 500 > tr.zip
+		no tr.zip
+		;;
+	esac
+done